@@ -0,0 +1,150 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cpu8080.h"
+#include "fused.h"
+#include "pacing.h"
+
+// Compares the plain per-opcode dispatch of Emulate8080Op against the
+// register-caching slice core and the superinstruction core on small
+// kernels. They are written to hit the fused patterns, so they show the
+// best case of each superinstruction, not its worth on a real program;
+// fusetune.sh measures that.
+
+typedef struct Workload {
+    const char *name;
+    const uint8_t *code;
+    size_t size;
+} Workload;
+
+// Copy 256 bytes from 0x1000 to 0x2400, forever
+static const uint8_t copy_kernel[] = {
+    0x31, 0x00, 0x24,       // 0000 LXI SP,$2400
+    0x11, 0x00, 0x10,       // 0003 LXI D,$1000
+    0x21, 0x00, 0x24,       // 0006 LXI H,$2400
+    0x06, 0x00,             // 0009 MVI B,0
+    0x1a, 0x77, 0x23, 0x13, // 000b LDAX D; MOV M,A; INX H; INX D
+    0x05, 0xc2, 0x0b, 0x00, // 000f DCR B; JNZ $000b
+    0xc3, 0x03, 0x00,       // 0013 JMP $0003
+};
+
+// Clear the 7K frame buffer, forever
+static const uint8_t clear_kernel[] = {
+    0x21, 0x00, 0x24,       // 0000 LXI H,$2400
+    0x0e, 0x1c,             // 0003 MVI C,$1c
+    0xaf,                   // 0005 XRA A
+    0x06, 0x00,             // 0006 MVI B,0
+    0x77, 0x23,             // 0008 MOV M,A; INX H
+    0x05, 0xc2, 0x08, 0x00, // 000a DCR B; JNZ $0008
+    0x0d, 0xc2, 0x06, 0x00, // 000e DCR C; JNZ $0006
+    0xc3, 0x00, 0x00,       // 0012 JMP $0000
+};
+
+// Read a table through HL, forever
+static const uint8_t scan_kernel[] = {
+    0x21, 0x00, 0x10,       // 0000 LXI H,$1000
+    0x0e, 0x00,             // 0003 MVI C,0
+    0x7e, 0x23,             // 0005 MOV A,M; INX H
+    0x5f,                   // 0007 MOV E,A
+    0x0d, 0xc2, 0x05, 0x00, // 0008 DCR C; JNZ $0005
+    0xc3, 0x00, 0x00,       // 000c JMP $0000
+};
+
+static const Workload workloads[] = {
+    {"copy", copy_kernel, sizeof(copy_kernel)},
+    {"clear", clear_kernel, sizeof(clear_kernel)},
+    {"scan", scan_kernel, sizeof(scan_kernel)},
+};
+
+static State8080 *Load(const Workload *w)
+{
+    State8080 *state = Init8080();
+    memset(state->memory, 0, 0x10000);
+    for (int i = 0; i < 0x100; i++)
+        state->memory[0x1000 + i] = (uint8_t) (i * 7);
+    memcpy(state->memory, w->code, w->size);
+    return state;
+}
+
+static int SameState(const State8080 *x, const State8080 *y)
+{
+    return x->a == y->a && x->b == y->b && x->c == y->c && x->d == y->d &&
+           x->e == y->e && x->h == y->h && x->l == y->l && x->sp == y->sp &&
+           x->pc == y->pc && x->cycles == y->cycles &&
+           memcmp(&x->cc, &y->cc, sizeof(x->cc)) == 0 &&
+           memcmp(x->memory, y->memory, 0x10000) == 0;
+}
+
+// The frontends run the CPU in slices up to the next scheduled event;
+// the beam interrupts come twice a frame
+#define SLICE 16667
+
+static DecodeCache *cache;
+
+static void RunSwitch(State8080 *state, uint64_t until)
+{
+    Run8080(state, until);
+}
+
+static void RunFused(State8080 *state, uint64_t until)
+{
+    Run8080Fused(state, cache, until);
+}
+
+static const struct {
+    const char *name;
+    void (*run)(State8080 *state, uint64_t until);
+} cores[] = {
+    {"switch", RunSwitch},
+    {"slice", Run8080Slice},
+    {"fused", RunFused},
+};
+
+#define NCORES (sizeof(cores) / sizeof(cores[0]))
+
+int main(int argc, char **argv) {
+    uint64_t cycles = 200000000;    // 100 emulated seconds
+    int failed = 0;
+
+    if (argc > 1)
+        cycles = strtoull(argv[1], NULL, 10);
+
+    printf("%-8s", "kernel");
+    for (size_t c = 0; c < NCORES; c++)
+        printf(" %8s MHz", cores[c].name);
+    printf("   speedup over %s\n", cores[0].name);
+    for (size_t i = 0; i < sizeof(workloads) / sizeof(workloads[0]); i++) {
+        const Workload *w = &workloads[i];
+        State8080 *state[NCORES];
+        double mhz[NCORES];
+
+        printf("%-8s", w->name);
+        for (size_t c = 0; c < NCORES; c++) {
+            state[c] = Load(w);
+            cache = DecodeCacheCreate();
+            uint64_t t0 = PacerNow();
+            for (uint64_t until = SLICE; state[c]->cycles < cycles; until += SLICE)
+                cores[c].run(state[c], until < cycles ? until : cycles);
+            uint64_t t1 = PacerNow();
+            free(cache);
+            mhz[c] = (double) state[c]->cycles / (t1 - t0) * 1000.0;
+            printf(" %12.1f", mhz[c]);
+        }
+        for (size_t c = 1; c < NCORES; c++)
+            printf(" %6.2fx", mhz[c] / mhz[0]);
+        printf("\n");
+
+        // All cores stop at the first opcode boundary past `cycles`
+        for (size_t c = 1; c < NCORES; c++) {
+            if (!SameState(state[0], state[c])) {
+                printf("error: %s: %s core diverged from Emulate8080Op\n", w->name, cores[c].name);
+                failed = 1;
+            }
+        }
+        for (size_t c = 0; c < NCORES; c++) {
+            free(state[c]->memory);
+            free(state[c]);
+        }
+    }
+    return failed;
+}
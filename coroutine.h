@@ -0,0 +1,40 @@
+#ifndef COROUTINE_H
+#define COROUTINE_H
+
+#include <stdint.h>
+
+// Stackless coroutines for devices. A device is a function that the
+// scheduler resumes at the cycle it asked for; it returns the next cycle
+// it wants to run at. Between waits nothing lives on the C stack, so
+// anything a device needs across a wait must be kept in its own struct,
+// and a wait cannot sit inside a switch of the coroutine body.
+//
+//   uint64_t Beam(void *ctx, uint64_t now) {
+//       Device *dev = ctx;
+//       CO_BEGIN(&dev->co);
+//       for (;;) {
+//           CO_WAIT_UNTIL(&dev->co, now + 100);
+//           ...
+//       }
+//       CO_END(&dev->co);
+//   }
+
+#define CO_DONE UINT64_MAX
+
+typedef struct Coroutine {
+    int line;               // where to resume; 0 before the first run
+} Coroutine;
+
+typedef uint64_t (*CoroutineFunc)(void *ctx, uint64_t now);
+
+#define CO_BEGIN(co) switch ((co)->line) { case 0:
+
+#define CO_WAIT_UNTIL(co, cycle) do { \
+        (co)->line = __LINE__; \
+        return (cycle); \
+        case __LINE__:; \
+    } while (0)
+
+#define CO_END(co) } (co)->line = -1; return CO_DONE
+
+#endif
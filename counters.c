@@ -0,0 +1,98 @@
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "counters.h"
+
+static const double frame_bounds[FRAME_BUCKETS] = {
+    0.0005, 0.001, 0.002, 0.004, 0.008, 1.0 / 60, 2.0 / 60, 4.0 / 60, 0.125, 0.25,
+};
+
+// Every set ever created. The lock only orders creation against the
+// readers walking the list; the counters themselves are never locked.
+static Counters *all;
+static pthread_mutex_t all_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Sets stay registered, and allocated, until the program exits
+Counters *CountersCreate(const char *name) {
+    Counters *counters = aligned_alloc(CACHE_LINE, sizeof(Counters));
+    memset(counters, 0, sizeof(Counters));
+    snprintf(counters->name, sizeof(counters->name), "%s", name);
+    pthread_mutex_lock(&all_lock);
+    Counters **tail = &all;
+    while (*tail)
+        tail = &(*tail)->next;
+    *tail = counters;
+    pthread_mutex_unlock(&all_lock);
+    return counters;
+}
+
+// Host time spent on one frame
+void CountersFrame(Counters *counters, uint64_t ns) {
+    int bucket = 0;
+    while (bucket < FRAME_BUCKETS && ns > frame_bounds[bucket] * 1e9)
+        bucket++;
+    COUNT(counters->frame_time[bucket], 1);
+    COUNT(counters->frames, 1);
+    COUNT(counters->frame_ns, ns);
+}
+
+static uint64_t Load(const _Atomic uint64_t *counter)
+{
+    return atomic_load_explicit(counter, memory_order_relaxed);
+}
+
+static void Counter(FILE *out, const char *name, const char *help, size_t offset)
+{
+    fprintf(out, "# HELP emu8080_%s %s\n# TYPE emu8080_%s counter\n", name, help, name);
+    for (Counters *c = all; c; c = c->next)
+        fprintf(out, "emu8080_%s{thread=\"%s\"} %llu\n", name, c->name,
+                (unsigned long long) Load((const _Atomic uint64_t *) ((char *) c + offset)));
+}
+
+static void PortCounter(FILE *out, const char *name, const char *help, size_t offset)
+{
+    fprintf(out, "# HELP emu8080_%s %s\n# TYPE emu8080_%s counter\n", name, help, name);
+    for (Counters *c = all; c; c = c->next) {
+        const _Atomic uint64_t *port = (const _Atomic uint64_t *) ((char *) c + offset);
+        for (int p = 0; p < IO_PORTS; p++)
+            if (Load(&port[p]))
+                fprintf(out, "emu8080_%s{thread=\"%s\",port=\"%d\"} %llu\n", name, c->name, p,
+                        (unsigned long long) Load(&port[p]));
+    }
+}
+
+// Every set in the Prometheus text format
+void CountersWrite(FILE *out) {
+    pthread_mutex_lock(&all_lock);
+    Counter(out, "instructions_total", "Instructions retired.",
+            offsetof(Counters, instructions));
+    Counter(out, "cycles_total", "CPU cycles emulated.", offsetof(Counters, cycles));
+    Counter(out, "interrupts_total", "Interrupts delivered.", offsetof(Counters, interrupts));
+    Counter(out, "decode_cache_hits_total", "Fused core decode cache hits.",
+            offsetof(Counters, decode_hits));
+    Counter(out, "decode_cache_misses_total", "Fused core decode cache misses.",
+            offsetof(Counters, decode_misses));
+    PortCounter(out, "port_reads_total", "IN instructions per port.", offsetof(Counters, port_in));
+    PortCounter(out, "port_writes_total", "OUT instructions per port.", offsetof(Counters, port_out));
+
+    fprintf(out, "# HELP emu8080_frame_seconds Host time per emulated frame.\n"
+                 "# TYPE emu8080_frame_seconds histogram\n");
+    for (Counters *c = all; c; c = c->next) {
+        uint64_t total = 0;
+        for (int b = 0; b <= FRAME_BUCKETS; b++) {
+            total += Load(&c->frame_time[b]);
+            if (b < FRAME_BUCKETS)
+                fprintf(out, "emu8080_frame_seconds_bucket{thread=\"%s\",le=\"%g\"} %llu\n",
+                        c->name, frame_bounds[b], (unsigned long long) total);
+            else
+                fprintf(out, "emu8080_frame_seconds_bucket{thread=\"%s\",le=\"+Inf\"} %llu\n",
+                        c->name, (unsigned long long) total);
+        }
+        fprintf(out, "emu8080_frame_seconds_sum{thread=\"%s\"} %.9f\n", c->name,
+                Load(&c->frame_ns) / 1e9);
+        fprintf(out, "emu8080_frame_seconds_count{thread=\"%s\"} %llu\n", c->name,
+                (unsigned long long) Load(&c->frames));
+    }
+    pthread_mutex_unlock(&all_lock);
+}
@@ -0,0 +1,41 @@
+#ifndef COUNTERS_H
+#define COUNTERS_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include "cpu8080.h"
+
+// Performance counters, one set per emulation thread, each on cache lines
+// of its own. Only the owning thread writes a set, as a relaxed load and
+// store, so counting takes no lock and no locked instruction; the cores
+// add their totals once per slice. Readers see each thread's set as is.
+
+// Upper bounds of the frame time histogram, in seconds; one more bucket
+// holds the rest
+#define FRAME_BUCKETS 10
+
+typedef struct Counters {
+    _Alignas(CACHE_LINE) _Atomic uint64_t instructions;
+    _Atomic uint64_t cycles;
+    _Atomic uint64_t interrupts;
+    _Atomic uint64_t decode_hits;       // fused core decode cache
+    _Atomic uint64_t decode_misses;
+    _Atomic uint64_t frames;
+    _Atomic uint64_t frame_ns;
+    _Atomic uint64_t frame_time[FRAME_BUCKETS + 1];
+    _Atomic uint64_t port_in[IO_PORTS];
+    _Atomic uint64_t port_out[IO_PORTS];
+    char name[32];                      // the thread label
+    struct Counters *next;
+} Counters;
+
+// For the owning thread only
+#define COUNT(counter, n) atomic_store_explicit(&(counter), \
+        atomic_load_explicit(&(counter), memory_order_relaxed) + (n), memory_order_relaxed)
+
+Counters *CountersCreate(const char *name);
+void CountersFrame(Counters *counters, uint64_t ns);
+void CountersWrite(FILE *out);
+
+#endif
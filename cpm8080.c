@@ -0,0 +1,576 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdint.h>
+#include <dirent.h>
+#include <poll.h>
+#include "cpu8080.h"
+#include "fused.h"
+#include "pacing.h"
+#include "profile.h"
+
+// CP/M runner: loads a .COM program at 0x100 and runs it headless at full
+// speed, serving its BDOS and BIOS calls from the host. The BDOS entry and
+// the BIOS jump table hold DI; HLT, so every core runs the program
+// unchanged and stops at a call; the call is then carried out here and
+// the CPU resumes at the caller with a RET. Nothing here interrupts the
+// CPU, so the DI only keeps a program that ran EI from having the cores
+// skip the cycle count ahead to the next interrupt at each call; the
+// program can't tell.
+//
+// Files are looked up in the current directory by their 8.3 name, in lower
+// case first and then as written. There is one drive and one user.
+
+#define TPA 0x0100
+#define BDOS 0xfe06         // also the top of the TPA, as read from 0x0006
+#define BIOS 0xff00
+#define BIOS_ENTRIES 17
+#define FCB1 0x005c
+#define FCB2 0x006c
+#define TAIL 0x0080
+#define RECORD 128
+#define MAX_FILES 16
+
+typedef struct Cpm {
+    State8080 *state;
+    uint16_t dma;
+    int done;
+    FILE *file[MAX_FILES];
+    uint16_t fcb[MAX_FILES];    // the FCB each open file belongs to
+    DIR *search;
+    char pattern[11];
+} Cpm;
+
+static DecodeCache *cache;
+
+static void RunFused(State8080 *state, uint64_t until)
+{
+    Run8080Fused(state, cache, until);
+}
+
+static const struct {
+    const char *name;
+    void (*run)(State8080 *state, uint64_t until);
+} cores[] = {
+    {"switch", Run8080},
+    {"slice", Run8080Slice},
+    {"fused", RunFused},
+};
+
+#define NCORES (sizeof(cores) / sizeof(cores[0]))
+
+static void Usage(const char *prog)
+{
+    printf("usage: %s [-core switch|slice|fused] [-stats] program.com [args...]\n", prog);
+    exit(1);
+}
+
+// Results go back in A and L, with the high byte in B and H
+static void Return16(State8080 *state, uint16_t value)
+{
+    state->a = state->l = value & 0xff;
+    state->b = state->h = value >> 8;
+}
+
+// Fills an FCB name from "d:name.ext"; * pads its field with ?
+static void ParseName(State8080 *state, uint16_t fcb, const char *arg)
+{
+    char name[11];
+    memset(name, ' ', sizeof(name));
+    if (arg[0] && arg[1] == ':') {
+        MemWrite(state, fcb, toupper((unsigned char) arg[0]) - 'A' + 1);
+        arg += 2;
+    }
+    int field = 0, n = 0;
+    for (; *arg; arg++) {
+        int width = field ? 3 : 8;
+        if (*arg == '.' && !field) {
+            field = 1;
+            n = 0;
+        } else if (*arg == '*') {
+            while (n < width)
+                name[field * 8 + n++] = '?';
+        } else if (n < width) {
+            name[field * 8 + n++] = toupper((unsigned char) *arg);
+        }
+    }
+    for (int i = 0; i < 11; i++)
+        MemWrite(state, fcb + 1 + i, name[i]);
+}
+
+// Builds the host file name from the 8.3 name in an FCB
+static void HostName(State8080 *state, uint16_t fcb, char *out, int lower)
+{
+    char *o = out;
+    for (int i = 0; i < 11; i++) {
+        char ch = MemRead(state, fcb + 1 + i) & 0x7f;
+        if (i == 8 && ch != ' ')
+            *o++ = '.';
+        if (ch != ' ')
+            *o++ = lower ? tolower((unsigned char) ch) : ch;
+    }
+    *o = '\0';
+}
+
+static FILE *OpenHost(State8080 *state, uint16_t fcb, const char *mode)
+{
+    char path[16];
+    HostName(state, fcb, path, 1);
+    FILE *f = fopen(path, mode);
+    if (f == NULL) {
+        HostName(state, fcb, path, 0);
+        f = fopen(path, mode);
+    }
+    return f;
+}
+
+static int FindFile(Cpm *cpm, uint16_t fcb)
+{
+    for (int i = 0; i < MAX_FILES; i++)
+        if (cpm->file[i] && cpm->fcb[i] == fcb)
+            return i;
+    return -1;
+}
+
+static int AddFile(Cpm *cpm, uint16_t fcb, FILE *f)
+{
+    for (int i = 0; i < MAX_FILES; i++) {
+        if (cpm->file[i] == NULL) {
+            cpm->file[i] = f;
+            cpm->fcb[i] = fcb;
+            return 0;
+        }
+    }
+    fclose(f);
+    return 0xff;
+}
+
+// The current record of the FCB, from its extent and record counter
+static uint32_t SequentialRecord(State8080 *state, uint16_t fcb)
+{
+    return (MemRead(state, fcb + 12) & 0x1f) * 128 + MemRead(state, fcb + 32);
+}
+
+static void SetSequentialRecord(State8080 *state, uint16_t fcb, uint32_t record)
+{
+    MemWrite(state, fcb + 12, (record / 128) & 0x1f);
+    MemWrite(state, fcb + 14, record / (32 * 128));
+    MemWrite(state, fcb + 32, record % 128);
+}
+
+static uint32_t RandomRecord(State8080 *state, uint16_t fcb)
+{
+    return MemRead(state, fcb + 33) | MemRead(state, fcb + 34) << 8 | MemRead(state, fcb + 35) << 16;
+}
+
+static void SetRandomRecord(State8080 *state, uint16_t fcb, uint32_t record)
+{
+    MemWrite(state, fcb + 33, record & 0xff);
+    MemWrite(state, fcb + 34, (record >> 8) & 0xff);
+    MemWrite(state, fcb + 35, (record >> 16) & 0xff);
+}
+
+// Reads one record into the DMA buffer, padding a short one with ^Z
+static int ReadRecord(Cpm *cpm, uint16_t fcb, uint32_t record)
+{
+    int i = FindFile(cpm, fcb);
+    if (i < 0)
+        return 9;
+    uint8_t buf[RECORD];
+    fseek(cpm->file[i], (long) record * RECORD, SEEK_SET);
+    size_t got = fread(buf, 1, RECORD, cpm->file[i]);
+    if (got == 0)
+        return 1;
+    memset(buf + got, 0x1a, RECORD - got);
+    for (int j = 0; j < RECORD; j++)
+        MemWrite(cpm->state, cpm->dma + j, buf[j]);
+    return 0;
+}
+
+static int WriteRecord(Cpm *cpm, uint16_t fcb, uint32_t record)
+{
+    int i = FindFile(cpm, fcb);
+    if (i < 0)
+        return 9;
+    uint8_t buf[RECORD];
+    for (int j = 0; j < RECORD; j++)
+        buf[j] = MemRead(cpm->state, cpm->dma + j);
+    fseek(cpm->file[i], (long) record * RECORD, SEEK_SET);
+    return fwrite(buf, RECORD, 1, cpm->file[i]) == 1 ? 0 : 2;
+}
+
+// Matches a host name against the 8.3 pattern of a search, ? matching
+// any character
+static int MatchName(const char *pattern, const char *host)
+{
+    char name[11];
+    memset(name, ' ', sizeof(name));
+    const char *dot = strrchr(host, '.');
+    size_t base = dot ? (size_t) (dot - host) : strlen(host);
+    if (base == 0 || base > 8 || (dot && strlen(dot + 1) > 3))
+        return 0;
+    for (size_t i = 0; i < base; i++)
+        name[i] = toupper((unsigned char) host[i]);
+    for (size_t i = 0; dot && dot[1 + i]; i++)
+        name[8 + i] = toupper((unsigned char) dot[1 + i]);
+    for (int i = 0; i < 11; i++)
+        if (pattern[i] != '?' && pattern[i] != name[i])
+            return 0;
+    return 1;
+}
+
+// Writes the next match as a directory entry at the DMA address
+static int SearchNext(Cpm *cpm)
+{
+    struct dirent *entry;
+    while (cpm->search && (entry = readdir(cpm->search)) != NULL) {
+        if (!MatchName(cpm->pattern, entry->d_name))
+            continue;
+        uint16_t dir = cpm->dma;
+        MemWrite(cpm->state, dir, 0);
+        ParseName(cpm->state, dir, entry->d_name);
+        for (int i = 12; i < 32; i++)
+            MemWrite(cpm->state, dir + i, 0);
+        return 0;
+    }
+    if (cpm->search) {
+        closedir(cpm->search);
+        cpm->search = NULL;
+    }
+    return 0xff;
+}
+
+static int ConsoleReady(void)
+{
+    struct pollfd pfd = {.fd = 0, .events = POLLIN};
+    return poll(&pfd, 1, 0) > 0;
+}
+
+static uint8_t ConsoleIn(void)
+{
+    fflush(stdout);
+    int ch = getchar();
+    return ch == EOF ? 0x1a : ch == '\n' ? '\r' : ch;
+}
+
+// Reads a line into the buffer at `buf`: its size, then the count and the
+// characters
+static void ReadLine(State8080 *state, uint16_t buf)
+{
+    uint8_t size = MemRead(state, buf);
+    int n = 0;
+    fflush(stdout);
+    for (;;) {
+        int ch = getchar();
+        if (ch == EOF || ch == '\n')
+            break;
+        if (n < size)
+            MemWrite(state, buf + 2 + n++, ch);
+    }
+    MemWrite(state, buf + 1, n);
+}
+
+static void Bdos(Cpm *cpm)
+{
+    State8080 *state = cpm->state;
+    uint16_t de = state->de;
+    uint16_t result = 0;
+    int i;
+
+    switch (state->c) {
+        case 0:     // system reset
+            cpm->done = 1;
+            break;
+        case 1:     // console input
+            result = ConsoleIn();
+            putchar(result);
+            break;
+        case 2:     // console output
+            putchar(state->e);
+            break;
+        case 6:     // direct console I/O
+            if (state->e == 0xff)
+                result = ConsoleReady() ? ConsoleIn() : 0;
+            else if (state->e == 0xfe)
+                result = ConsoleReady() ? 0xff : 0;
+            else
+                putchar(state->e);
+            break;
+        case 9:     // print string
+            for (uint16_t a = de; MemRead(state, a) != '$'; a++)
+                putchar(MemRead(state, a));
+            break;
+        case 10:    // read console buffer
+            ReadLine(state, de);
+            break;
+        case 11:    // console status
+            result = ConsoleReady() ? 0xff : 0;
+            break;
+        case 12:    // version: CP/M 2.2
+            result = 0x0022;
+            break;
+        case 13:    // reset disk system
+            cpm->dma = TAIL;
+            break;
+        case 14:    // select disk
+        case 25:    // current disk
+        case 32:    // user code
+            break;
+        case 15:    // open file
+        {
+            FILE *f = OpenHost(state, de, "r+b");
+            if (f == NULL)
+                f = OpenHost(state, de, "rb");
+            result = f ? AddFile(cpm, de, f) : 0xff;
+            MemWrite(state, de + 12, 0);
+            MemWrite(state, de + 32, 0);
+        }
+            break;
+        case 16:    // close file
+            i = FindFile(cpm, de);
+            if (i >= 0) {
+                fclose(cpm->file[i]);
+                cpm->file[i] = NULL;
+            }
+            break;
+        case 17:    // search for first
+        {
+            for (int j = 0; j < 11; j++)
+                cpm->pattern[j] = toupper(MemRead(state, de + 1 + j) & 0x7f);
+            if (cpm->search)
+                closedir(cpm->search);
+            cpm->search = opendir(".");
+            result = SearchNext(cpm);
+        }
+            break;
+        case 18:    // search for next
+            result = SearchNext(cpm);
+            break;
+        case 19:    // delete file
+        {
+            char path[16];
+            HostName(state, de, path, 1);
+            result = 0;
+            if (remove(path) != 0) {
+                HostName(state, de, path, 0);
+                result = remove(path) == 0 ? 0 : 0xff;
+            }
+        }
+            break;
+        case 20:    // read sequential
+        {
+            uint32_t record = SequentialRecord(state, de);
+            result = ReadRecord(cpm, de, record);
+            if (result == 0)
+                SetSequentialRecord(state, de, record + 1);
+        }
+            break;
+        case 21:    // write sequential
+        {
+            uint32_t record = SequentialRecord(state, de);
+            result = WriteRecord(cpm, de, record);
+            if (result == 0)
+                SetSequentialRecord(state, de, record + 1);
+        }
+            break;
+        case 22:    // make file
+        {
+            FILE *f = OpenHost(state, de, "w+b");
+            result = f ? AddFile(cpm, de, f) : 0xff;
+            MemWrite(state, de + 12, 0);
+            MemWrite(state, de + 32, 0);
+        }
+            break;
+        case 23:    // rename file: the new name is in the second half
+        {
+            char from[16], to[16];
+            HostName(state, de, from, 1);
+            HostName(state, de + 16, to, 1);
+            result = rename(from, to) == 0 ? 0 : 0xff;
+        }
+            break;
+        case 26:    // set DMA address
+            cpm->dma = de;
+            break;
+        case 33:    // read random
+        case 34:    // write random
+        {
+            uint32_t record = RandomRecord(state, de);
+            result = state->c == 33 ? ReadRecord(cpm, de, record) : WriteRecord(cpm, de, record);
+            if (result == 1)
+                result = 6;     // reading past the end is an unwritten record
+            SetSequentialRecord(state, de, record);
+        }
+            break;
+        case 35:    // compute file size
+            i = FindFile(cpm, de);
+            if (i < 0) {
+                FILE *f = OpenHost(state, de, "rb");
+                if (f == NULL) {
+                    result = 0xff;
+                    break;
+                }
+                fseek(f, 0, SEEK_END);
+                SetRandomRecord(state, de, (ftell(f) + RECORD - 1) / RECORD);
+                fclose(f);
+            } else {
+                fflush(cpm->file[i]);
+                fseek(cpm->file[i], 0, SEEK_END);
+                SetRandomRecord(state, de, (ftell(cpm->file[i]) + RECORD - 1) / RECORD);
+            }
+            break;
+        case 36:    // set random record
+            SetRandomRecord(state, de, SequentialRecord(state, de));
+            break;
+        default:
+            fflush(stdout);
+            printf("error: BDOS function %d not supported, called from $%04x\n",
+                   state->c, MemRead(state, state->sp) | MemRead(state, state->sp + 1) << 8);
+            exit(1);
+    }
+    Return16(state, result);
+}
+
+// Only the console entries do anything; the disk entries fail
+static void Bios(Cpm *cpm, int entry)
+{
+    State8080 *state = cpm->state;
+    switch (entry) {
+        case 0:     // cold boot
+        case 1:     // warm boot
+            cpm->done = 1;
+            break;
+        case 2:     // console status
+            state->a = ConsoleReady() ? 0xff : 0;
+            break;
+        case 3:     // console input
+            state->a = ConsoleIn();
+            break;
+        case 4:     // console output
+        case 5:     // list output
+            putchar(state->c);
+            break;
+        default:
+            state->a = 0xff;
+            break;
+    }
+}
+
+// Page zero and the trap instructions
+static void Boot(Cpm *cpm, const char *path, int argc, char **argv)
+{
+    State8080 *state = cpm->state;
+
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        printf("error: Couldn't open %s\n", path);
+        exit(1);
+    }
+    size_t size = fread(&state->memory[TPA], 1, BDOS - TPA, f);
+    if (size == BDOS - TPA && fgetc(f) != EOF) {
+        printf("error: %s does not fit in the TPA\n", path);
+        exit(1);
+    }
+    fclose(f);
+
+    // JMP WBOOT; IOBYTE; drive; JMP BDOS
+    state->memory[0x0000] = 0xc3;
+    state->memory[0x0001] = (BIOS + 3) & 0xff;
+    state->memory[0x0002] = (BIOS + 3) >> 8;
+    state->memory[0x0005] = 0xc3;
+    state->memory[0x0006] = BDOS & 0xff;
+    state->memory[0x0007] = BDOS >> 8;
+    state->memory[BDOS] = 0xf3;
+    state->memory[BDOS + 1] = 0x76;
+    for (int i = 0; i < BIOS_ENTRIES; i++) {
+        state->memory[BIOS + 3 * i] = 0xf3;
+        state->memory[BIOS + 3 * i + 1] = 0x76;
+    }
+
+    // The command tail, and the first two arguments parsed as file names
+    memset(&state->memory[FCB1], 0, 0x100 - FCB1);
+    ParseName(state, FCB1, argc > 0 ? argv[0] : "");
+    ParseName(state, FCB2, argc > 1 ? argv[1] : "");
+    int n = 0;
+    for (int i = 0; i < argc; i++) {
+        if (n < 127)
+            state->memory[TAIL + 1 + n++] = ' ';
+        for (const char *p = argv[i]; *p && n < 127; p++)
+            state->memory[TAIL + 1 + n++] = toupper((unsigned char) *p);
+    }
+    state->memory[TAIL] = n;
+    cpm->dma = TAIL;
+
+    // A program that returns from its main lands on the warm boot
+    state->pc = TPA;
+    state->sp = BDOS - 2;
+    MemWrite(state, state->sp, 0);
+    MemWrite(state, state->sp + 1, 0);
+}
+
+int main(int argc, char **argv) {
+    const char *core = "fused";
+    int show_stats = 0;
+    int i;
+
+    for (i = 1; i < argc && argv[i][0] == '-'; i++) {
+        if (strcmp(argv[i], "-core") == 0 && i + 1 < argc)
+            core = argv[++i];
+        else if (strcmp(argv[i], "-stats") == 0)
+            show_stats = 1;
+        else
+            Usage(argv[0]);
+    }
+    if (i >= argc)
+        Usage(argv[0]);
+
+    size_t c;
+    for (c = 0; c < NCORES && strcmp(cores[c].name, core) != 0; c++)
+        ;
+    if (c == NCORES)
+        Usage(argv[0]);
+    cache = DecodeCacheCreate();
+
+    Cpm cpm = {0};
+    cpm.state = Init8080();
+    Boot(&cpm, argv[i], argc - i - 1, argv + i + 1);
+
+    State8080 *state = cpm.state;
+    uint64_t t0 = PacerNow();
+    while (!cpm.done) {
+        cores[c].run(state, state->cycles + 100000000);
+        if (!state->halted)
+            continue;
+
+        // Trapped: carry out the call and return to the caller. `at` is
+        // the entry, the DI before the HLT.
+        uint16_t at = state->pc - 2;
+        if (at == BDOS)
+            Bdos(&cpm);
+        else if (at >= BIOS && at < BIOS + 3 * BIOS_ENTRIES && (at - BIOS) % 3 == 0)
+            Bios(&cpm, (at - BIOS) / 3);
+        else {
+            fflush(stdout);
+            printf("error: CPU halted at $%04x\n", state->pc - 1);
+            exit(1);
+        }
+        state->halted = 0;
+        state->pc = MemRead(state, state->sp) | MemRead(state, state->sp + 1) << 8;
+        state->sp += 2;
+    }
+    double seconds = (PacerNow() - t0) / 1e9;
+    fflush(stdout);
+
+    if (show_stats)
+        fprintf(stderr, "%llu cycles in %.3f s, %.1f MHz on the %s core\n",
+                (unsigned long long) state->cycles, seconds,
+                state->cycles / seconds / 1e6, cores[c].name);
+#ifdef PROFILE
+    ProfileReport(state->memory, 40);
+#endif
+    for (int j = 0; j < MAX_FILES; j++)
+        if (cpm.file[j])
+            fclose(cpm.file[j]);
+    return 0;
+}
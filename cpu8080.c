@@ -0,0 +1,245 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "cpu8080.h"
+#include "profile.h"
+#include "idle.h"
+#include "counters.h"
+#include "disasm.h"
+#include "ops8080.h"
+
+#define CYCLES_ENTRY(op, length, cycles, handler) [op] = cycles,
+#define LENGTH_ENTRY(op, length, cycles, handler) [op] = length,
+
+// Clock cycles per opcode. Conditional calls and returns list the
+// not-taken count; the handlers add 6 when the branch is taken.
+const uint8_t cycles8080[256] = { OPCODES8080(CYCLES_ENTRY) };
+
+// Instruction lengths in bytes
+const uint8_t length8080[256] = { OPCODES8080(LENGTH_ENTRY) };
+
+#undef CYCLES_ENTRY
+#undef LENGTH_ENTRY
+
+// 1 when the byte has an even number of set bits
+const uint8_t parity8080[256] = {
+    1, 0, 0, 1, 0, 1, 1, 0, 0, 1, 1, 0, 1, 0, 0, 1, //0x00..0x0f
+    0, 1, 1, 0, 1, 0, 0, 1, 1, 0, 0, 1, 0, 1, 1, 0, //0x10..0x1f
+    0, 1, 1, 0, 1, 0, 0, 1, 1, 0, 0, 1, 0, 1, 1, 0, //0x20..0x2f
+    1, 0, 0, 1, 0, 1, 1, 0, 0, 1, 1, 0, 1, 0, 0, 1, //0x30..0x3f
+    0, 1, 1, 0, 1, 0, 0, 1, 1, 0, 0, 1, 0, 1, 1, 0, //0x40..0x4f
+    1, 0, 0, 1, 0, 1, 1, 0, 0, 1, 1, 0, 1, 0, 0, 1, //0x50..0x5f
+    1, 0, 0, 1, 0, 1, 1, 0, 0, 1, 1, 0, 1, 0, 0, 1, //0x60..0x6f
+    0, 1, 1, 0, 1, 0, 0, 1, 1, 0, 0, 1, 0, 1, 1, 0, //0x70..0x7f
+    0, 1, 1, 0, 1, 0, 0, 1, 1, 0, 0, 1, 0, 1, 1, 0, //0x80..0x8f
+    1, 0, 0, 1, 0, 1, 1, 0, 0, 1, 1, 0, 1, 0, 0, 1, //0x90..0x9f
+    1, 0, 0, 1, 0, 1, 1, 0, 0, 1, 1, 0, 1, 0, 0, 1, //0xa0..0xaf
+    0, 1, 1, 0, 1, 0, 0, 1, 1, 0, 0, 1, 0, 1, 1, 0, //0xb0..0xbf
+    1, 0, 0, 1, 0, 1, 1, 0, 0, 1, 1, 0, 1, 0, 0, 1, //0xc0..0xcf
+    0, 1, 1, 0, 1, 0, 0, 1, 1, 0, 0, 1, 0, 1, 1, 0, //0xd0..0xdf
+    0, 1, 1, 0, 1, 0, 0, 1, 1, 0, 0, 1, 0, 1, 1, 0, //0xe0..0xef
+    1, 0, 0, 1, 0, 1, 1, 0, 0, 1, 1, 0, 1, 0, 0, 1, //0xf0..0xff
+};
+
+int Emulate8080Op(State8080 *state) {
+
+    uint8_t fetch[3];
+    const uint8_t *opcode = MemFetch(state, state->pc, fetch);
+#ifdef PROFILE
+    uint16_t start_pc = state->pc;
+    uint8_t start_op = *opcode;
+    uint64_t start_cycles = state->cycles;
+#endif
+#ifdef TRACE
+    Instr8080 trace_ins;
+    char trace_text[32];
+    uint16_t trace_pc = state->pc;
+    Decode8080(opcode, trace_pc, &trace_ins);
+    Format8080(&trace_ins, trace_text, sizeof(trace_text), NULL);
+#endif
+    state->cycles += cycles8080[*opcode];
+
+    state->pc += 1;
+#include "state8080.inc"
+#include "ops8080.inc"
+#ifdef TRACE
+    printf("%04x %-20s %c%c%c%c%c  A $%02x B $%02x C $%02x D $%02x E $%02x H $%02x L $%02x SP %04x\n",
+           trace_pc, trace_text,
+           state->cc.z ? 'z' : '.', state->cc.s ? 's' : '.', state->cc.p ? 'p' : '.',
+           state->cc.cy ? 'c' : '.', state->cc.ac ? 'a' : '.',
+           state->a, state->b, state->c, state->d, state->e, state->h, state->l, state->sp);
+#endif
+    PROFILE_RECORD(start_pc, start_op, state->cycles - start_cycles);
+    return 0;
+}
+
+// Runs the CPU one opcode at a time until the cycle counter reaches `until`
+void Run8080(State8080 *state, uint64_t until) {
+    uint64_t start = state->cycles, retired = 0;
+    while (state->cycles < until) {
+        // a halted CPU does nothing until the next interrupt, and with
+        // interrupts off the clock stops where it halted
+        if (state->halted) {
+            if (state->int_enable)
+                state->cycles = until;
+            break;
+        }
+        IdleOnOpcode(state, until);
+        Emulate8080Op(state);
+        retired++;
+    }
+    if (state->counters) {
+        COUNT(state->counters->instructions, retired);
+        COUNT(state->counters->cycles, state->cycles - start);
+    }
+}
+
+// Same as Run8080, but with the registers copied into locals for the
+// whole slice so the compiler can keep them in host registers. They are
+// written back to the state only around idle checks and at the end.
+void Run8080Slice(State8080 *state, uint64_t until) {
+#if defined(TRACE) || defined(PROFILE)
+    // tracing and profiling hook into Emulate8080Op
+    Run8080(state, until);
+    return;
+#endif
+    uint8_t *memory = state->memory;
+    MemoryMap *map = state->map;
+    IdleDetector *idle = state->idle;
+    uint8_t a, b, c, d, e, h, l, int_enable, halted;
+    uint16_t sp, pc;
+    ConditionCodes cc;
+    uint64_t cycles;
+    uint64_t start = state->cycles, retired = 0;
+    uint8_t fetch[3];
+
+#define LOAD() do { \
+        a = state->a; b = state->b; c = state->c; d = state->d; \
+        e = state->e; h = state->h; l = state->l; \
+        sp = state->sp; pc = state->pc; cc = state->cc; cycles = state->cycles; \
+        int_enable = state->int_enable; halted = state->halted; \
+    } while (0)
+#define SAVE() do { \
+        state->a = a; state->b = b; state->c = c; state->d = d; \
+        state->e = e; state->h = h; state->l = l; \
+        state->sp = sp; state->pc = pc; state->cc = cc; state->cycles = cycles; \
+        state->int_enable = int_enable; state->halted = halted; \
+    } while (0)
+
+    LOAD();
+    while (cycles < until) {
+        if (halted) {
+            if (int_enable)
+                cycles = until;
+            break;
+        }
+        const uint8_t *opcode = MapFetch(memory, map, pc, fetch);
+        if (idle && idle_jump[*opcode]) {
+            SAVE();
+            IdleCheck(idle, state, until);
+            LOAD();
+            opcode = MapFetch(memory, map, pc, fetch);
+        }
+        cycles += cycles8080[*opcode];
+        pc += 1;
+        retired++;
+
+#define A a
+#define B b
+#define C c
+#define D d
+#define E e
+#define H h
+#define L l
+#define BC ((uint16_t) (b << 8 | c))
+#define DE ((uint16_t) (d << 8 | e))
+#define HL ((uint16_t) (h << 8 | l))
+#define SET_BC(v) do { uint16_t pair_ = (v); b = pair_ >> 8; c = pair_; } while (0)
+#define SET_DE(v) do { uint16_t pair_ = (v); d = pair_ >> 8; e = pair_; } while (0)
+#define SET_HL(v) do { uint16_t pair_ = (v); h = pair_ >> 8; l = pair_; } while (0)
+#define SP sp
+#define PC pc
+#define CC cc
+#define READ8(addr) MapRead(memory, map, addr)
+#define WRITE8(addr, value) MapWrite(memory, map, addr, value)
+#define CYCLES cycles
+#define INT_ENABLE int_enable
+#define HALTED halted
+#define PORT_IN(port) (state->cycles = cycles, state->port_in(state, port))
+#define PORT_OUT(port, value) (state->cycles = cycles, state->port_out(state, port, value))
+#include "ops8080.inc"
+    }
+    SAVE();
+    if (state->counters) {
+        COUNT(state->counters->instructions, retired);
+        COUNT(state->counters->cycles, cycles - start);
+    }
+#undef LOAD
+#undef SAVE
+}
+
+static void Push(State8080* state, uint8_t high, uint8_t low)
+{
+    MemWrite(state, state->sp - 1, high);
+    MemWrite(state, state->sp - 2, low);
+    state->sp = state->sp - 2;
+}
+
+void ReadFileIntoMemoryAt(State8080 *state, char *filename, uint32_t offset) {
+    FILE *f = fopen(filename, "rb");
+    if (f == NULL) {
+        printf("error: Couldn't open %s\n", filename);
+        exit(1);
+    }
+    fseek(f, 0L, SEEK_END);
+    int fsize = ftell(f);
+    fseek(f, 0L, SEEK_SET);
+
+    uint8_t *buffer = &state->memory[offset];
+    fread(buffer, fsize, 1, f);
+    fclose(f);
+}
+
+void GenerateInterrupt(State8080* state, int interrupt_num)
+{
+    // interrupt requests are ignored while interrupts are disabled
+    if (!state->int_enable)
+        return;
+
+    //perform "PUSH PC"
+    Push(state, (state->pc & 0xFF00) >> 8, (state->pc & 0xff));
+
+    //Set the PC to the low memory vector.
+    //This is identical to an "RST interrupt_num" instruction.
+    state->pc = 8 * interrupt_num;
+    state->cycles += 11;    // same cost as RST
+
+    // Accepting an interrupt disables further ones until the ISR runs EI
+    state->int_enable = 0;
+    state->halted = 0;
+    if (state->counters)
+        COUNT(state->counters->interrupts, 1);
+}
+
+_Static_assert(offsetof(State8080, halted) < CACHE_LINE, "hot CPU state must fit in one cache line");
+
+// No board behind the ports
+uint8_t PortInNone(State8080 *state, uint8_t port) {
+    return 0;
+}
+
+void PortOutNone(State8080 *state, uint8_t port, uint8_t value) {
+}
+
+State8080 *Init8080(void) {
+    State8080 *state = aligned_alloc(CACHE_LINE, sizeof(State8080));
+    memset(state, 0, sizeof(State8080));
+    state->port_in = PortInNone;
+    state->port_out = PortOutNone;
+    state->memory = calloc(1, MEMORY_ALLOC);
+    state->map = malloc(sizeof(MemoryMap));
+    MemoryMapFlat(state->map);
+    return state;
+}
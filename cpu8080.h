@@ -0,0 +1,105 @@
+#ifndef CPU8080_H
+#define CPU8080_H
+
+#include <stdint.h>
+#include "memmap.h"
+
+typedef struct ConditionCodes {
+    uint8_t z:1;
+    uint8_t s:1;
+    uint8_t p:1;
+    uint8_t cy:1;
+    uint8_t ac:1;
+    uint8_t pad:3;
+} ConditionCodes;
+
+// Board I/O kept with the CPU: the input port levels the frontend sets,
+// and the shift register the Space Invaders family of boards shifts
+// sprites with. These boards decode three address lines for ports.
+#define IO_PORTS 8
+
+typedef struct Ports {
+    uint8_t     in[IO_PORTS];
+    uint16_t    shift;          // the last two bytes written, newest high
+    uint8_t     shift_amount;   // bits 0,1,2
+} Ports;
+
+// A register pair overlays its two 8-bit halves, so 16-bit operations are
+// one load or store and the 8-bit registers keep their names.
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define REGISTER_PAIR(pair, hi, lo) union { uint16_t pair; struct { uint8_t hi, lo; }; }
+#else
+#define REGISTER_PAIR(pair, hi, lo) union { uint16_t pair; struct { uint8_t lo, hi; }; }
+#endif
+
+#define CACHE_LINE 64
+
+// IN and OUT go through these. Init8080 installs handlers that read 0 and
+// drop writes; MachineLoad replaces them with the board's. The slice core
+// keeps registers in locals, so handlers can rely on `cycles` but not on
+// the other registers in `state`.
+struct State8080;
+typedef uint8_t (*PortIn)(struct State8080 *state, uint8_t port);
+typedef void (*PortOut)(struct State8080 *state, uint8_t port, uint8_t value);
+
+// Everything the cores touch per instruction shares the first cache
+// line: the memory and its map, cycle counter, PC, SP and the registers.
+// psw pairs A with the flags as stored here, not the byte PUSH PSW
+// writes.
+typedef struct State8080 {
+    _Alignas(CACHE_LINE) uint8_t *memory;   // MEMORY_ALLOC bytes
+    MemoryMap *map;
+    uint64_t cycles;
+    uint16_t pc;
+    uint16_t sp;
+    union {
+        uint16_t psw;
+        struct {
+            struct ConditionCodes cc;
+            uint8_t a;
+        };
+    };
+    REGISTER_PAIR(bc, b, c);
+    REGISTER_PAIR(de, d, e);
+    REGISTER_PAIR(hl, h, l);
+    uint8_t int_enable;
+    uint8_t halted;
+    struct Ports port;
+    struct IdleDetector *idle;  // NULL disables idle-loop skipping
+    PortIn port_in;
+    PortOut port_out;
+    const void *board;          // for the port handlers
+    struct Counters *counters;  // NULL disables counting
+} State8080;
+
+static inline uint8_t MemRead(const State8080 *state, uint16_t addr)
+{
+    return MapRead(state->memory, state->map, addr);
+}
+
+static inline void MemWrite(State8080 *state, uint16_t addr, uint8_t value)
+{
+    MapWrite(state->memory, state->map, addr, value);
+}
+
+// The opcode at addr, with its operands following it; `buf` holds three
+// bytes for when they cross a page
+static inline const uint8_t *MemFetch(const State8080 *state, uint16_t addr, uint8_t *buf)
+{
+    return MapFetch(state->memory, state->map, addr, buf);
+}
+
+extern const uint8_t cycles8080[256];
+extern const uint8_t length8080[256];
+extern const uint8_t parity8080[256];
+
+int Emulate8080Op(State8080 *state);
+void Run8080(State8080 *state, uint64_t until);
+void Run8080Slice(State8080 *state, uint64_t until);
+void GenerateInterrupt(State8080* state, int interrupt_num);
+void ReadFileIntoMemoryAt(State8080 *state, char *filename, uint32_t offset);
+uint8_t PortInNone(State8080 *state, uint8_t port);
+void PortOutNone(State8080 *state, uint8_t port, uint8_t value);
+State8080 *Init8080(void);
+
+#endif
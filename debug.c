@@ -0,0 +1,546 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include "debug.h"
+#include "net.h"
+
+#define MAX_PACKET 4096
+
+static const char hexdigits[] = "0123456789abcdef";
+
+static int HexValue(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+static unsigned long ParseHex(const char **p)
+{
+    unsigned long v = 0;
+    int d;
+    while ((d = HexValue(**p)) >= 0) {
+        v = v * 16 + d;
+        (*p)++;
+    }
+    return v;
+}
+
+static char *PutHexByte(char *out, uint8_t b)
+{
+    *out++ = hexdigits[b >> 4];
+    *out++ = hexdigits[b & 0xf];
+    return out;
+}
+
+static void SetBit(uint8_t *bitmap, uint16_t addr, int on)
+{
+    if (on)
+        bitmap[addr >> 3] |= 1 << (addr & 7);
+    else
+        bitmap[addr >> 3] &= ~(1 << (addr & 7));
+}
+
+static void UpdateArmed(Debugger *dbg)
+{
+    dbg->armed = dbg->num_breakpoints > 0 || dbg->num_watchpoints > 0 ||
+                 dbg->stepping || dbg->run_to >= 0;
+}
+
+// Listens on "host:port", ":port" or a Unix socket path and waits for
+// the client. The CPU starts stopped so the client can set breakpoints.
+Debugger *DebugCreate(const char *address) {
+    Debugger *dbg = calloc(1, sizeof(Debugger));
+
+    dbg->run_to = -1;
+    dbg->resume_pc = -1;
+    dbg->fd = -1;
+    dbg->listen_fd = ListenOn(address, 1);
+
+    printf("waiting for debugger on %s\n", address);
+    dbg->fd = accept(dbg->listen_fd, NULL, NULL);
+    if (dbg->fd < 0) {
+        printf("error: accept failed on %s\n", address);
+        exit(1);
+    }
+    dbg->stopped = 1;
+    strcpy(dbg->stop_reason, "S05");
+    return dbg;
+}
+
+static void Disconnect(Debugger *dbg)
+{
+    close(dbg->fd);
+    dbg->fd = -1;
+    dbg->stopped = 0;
+    dbg->stepping = 0;
+    dbg->run_to = -1;
+    memset(dbg->breakpoints, 0, sizeof(dbg->breakpoints));
+    memset(dbg->watch_read, 0, sizeof(dbg->watch_read));
+    memset(dbg->watch_write, 0, sizeof(dbg->watch_write));
+    memset(dbg->watch_access, 0, sizeof(dbg->watch_access));
+    dbg->num_breakpoints = dbg->num_watchpoints = 0;
+    UpdateArmed(dbg);
+}
+
+static int ReadByte(Debugger *dbg)
+{
+    unsigned char c;
+    if (dbg->fd < 0 || read(dbg->fd, &c, 1) != 1)
+        return -1;
+    return c;
+}
+
+static void PutPacket(Debugger *dbg, const char *data)
+{
+    char buf[MAX_PACKET * 2 + 8];
+    uint8_t sum = 0;
+    size_t n = strlen(data);
+    buf[0] = '$';
+    memcpy(buf + 1, data, n);
+    for (size_t i = 0; i < n; i++)
+        sum += (uint8_t) data[i];
+    buf[n + 1] = '#';
+    PutHexByte(buf + n + 2, sum);
+    if (write(dbg->fd, buf, n + 4) < 0)
+        Disconnect(dbg);
+}
+
+// Reads one packet into buf. Returns its length, -1 when the client went
+// away, or -2 for an out-of-band interrupt (Ctrl-C).
+static int GetPacket(Debugger *dbg, char *buf)
+{
+    int c;
+    for (;;) {
+        while ((c = ReadByte(dbg)) != '$') {
+            if (c < 0)
+                return -1;
+            if (c == 0x03)
+                return -2;
+        }
+        int n = 0;
+        uint8_t sum = 0;
+        while ((c = ReadByte(dbg)) >= 0 && c != '#') {
+            if (n < MAX_PACKET - 1)
+                buf[n++] = (char) c;
+            sum += (uint8_t) c;
+        }
+        int hi = HexValue(ReadByte(dbg));
+        int lo = HexValue(ReadByte(dbg));
+        if (c < 0 || hi < 0 || lo < 0)
+            return -1;
+        buf[n] = '\0';
+        if ((hi << 4 | lo) == sum) {
+            if (write(dbg->fd, "+", 1) < 0)
+                return -1;
+            return n;
+        }
+        if (write(dbg->fd, "-", 1) < 0)
+            return -1;
+    }
+}
+
+static uint8_t GetFlags(const State8080 *state)
+{
+    return state->cc.z | state->cc.s << 1 | state->cc.p << 2 | state->cc.cy << 3 | state->cc.ac << 4;
+}
+
+static void SetFlags(State8080 *state, uint8_t psw)
+{
+    state->cc.z = psw & 1;
+    state->cc.s = (psw >> 1) & 1;
+    state->cc.p = (psw >> 2) & 1;
+    state->cc.cy = (psw >> 3) & 1;
+    state->cc.ac = (psw >> 4) & 1;
+}
+
+static unsigned GetRegister(const State8080 *state, int n)
+{
+    switch (n) {
+        case 0: return state->a;
+        case 1: return GetFlags(state);
+        case 2: return state->b;
+        case 3: return state->c;
+        case 4: return state->d;
+        case 5: return state->e;
+        case 6: return state->h;
+        case 7: return state->l;
+        case 8: return state->sp;
+        default: return state->pc;
+    }
+}
+
+static void SetRegister(State8080 *state, int n, unsigned v)
+{
+    switch (n) {
+        case 0: state->a = v; break;
+        case 1: SetFlags(state, v); break;
+        case 2: state->b = v; break;
+        case 3: state->c = v; break;
+        case 4: state->d = v; break;
+        case 5: state->e = v; break;
+        case 6: state->h = v; break;
+        case 7: state->l = v; break;
+        case 8: state->sp = v; break;
+        default: state->pc = v; break;
+    }
+}
+
+static int RegisterSize(int n)
+{
+    return n >= 8 ? 2 : 1;
+}
+
+static char *PutRegister(char *out, const State8080 *state, int n)
+{
+    unsigned v = GetRegister(state, n);
+    out = PutHexByte(out, v & 0xff);
+    if (RegisterSize(n) == 2)
+        out = PutHexByte(out, v >> 8);
+    return out;
+}
+
+// Parses a register value in target (little endian) byte order
+static unsigned ParseRegister(const char **p, int n)
+{
+    unsigned v = 0;
+    for (int i = 0; i < RegisterSize(n); i++) {
+        int hi = HexValue((*p)[0]), lo = HexValue((*p)[1]);
+        if (hi < 0 || lo < 0)
+            break;
+        v |= (unsigned) (hi << 4 | lo) << (8 * i);
+        *p += 2;
+    }
+    return v;
+}
+
+static int WatchedAt(const Debugger *dbg, uint16_t a)
+{
+    return DebugBit(dbg->watch_read, a) | DebugBit(dbg->watch_write, a) | DebugBit(dbg->watch_access, a);
+}
+
+static void SetPoint(Debugger *dbg, int type, uint16_t addr, int len, int on)
+{
+    int *count = type <= 1 ? &dbg->num_breakpoints : &dbg->num_watchpoints;
+    if (len < 1)
+        len = 1;
+    for (int i = 0; i < len; i++) {
+        uint16_t a = addr + i;
+        if (type <= 1) {
+            *count += on - DebugBit(dbg->breakpoints, a);
+            SetBit(dbg->breakpoints, a, on);
+            break;
+        }
+        int was = WatchedAt(dbg, a);
+        SetBit(type == 2 ? dbg->watch_write : type == 3 ? dbg->watch_read : dbg->watch_access, a, on);
+        *count += WatchedAt(dbg, a) - was;
+    }
+    UpdateArmed(dbg);
+}
+
+static void Monitor(Debugger *dbg, State8080 *state, const char *hex)
+{
+    char cmd[256], out[MAX_PACKET], text[256];
+    size_t n = 0;
+    while (hex[0] && hex[1] && n < sizeof(cmd) - 1) {
+        cmd[n++] = (char) (HexValue(hex[0]) << 4 | HexValue(hex[1]));
+        hex += 2;
+    }
+    cmd[n] = '\0';
+
+    if (strcmp(cmd, "regs") == 0) {
+        snprintf(text, sizeof(text),
+                 "A %02x B %02x C %02x D %02x E %02x H %02x L %02x SP %04x PC %04x  %c%c%c%c%c  cycles %llu\n",
+                 state->a, state->b, state->c, state->d, state->e, state->h, state->l,
+                 state->sp, state->pc,
+                 state->cc.z ? 'z' : '.', state->cc.s ? 's' : '.', state->cc.p ? 'p' : '.',
+                 state->cc.cy ? 'c' : '.', state->cc.ac ? 'a' : '.',
+                 (unsigned long long) state->cycles);
+    } else if (strncmp(cmd, "runto ", 6) == 0) {
+        const char *p = cmd + 6;
+        dbg->run_to = (int) (ParseHex(&p) & 0xffff);
+        UpdateArmed(dbg);
+        snprintf(text, sizeof(text), "will stop at $%04x on continue\n", dbg->run_to);
+    } else {
+        snprintf(text, sizeof(text), "commands: regs, runto <hex address>\n");
+    }
+    char *o = out;
+    *o++ = 'O';
+    for (const char *t = text; *t; t++)
+        o = PutHexByte(o, (uint8_t) *t);
+    *o = '\0';
+    PutPacket(dbg, out);
+    PutPacket(dbg, "OK");
+}
+
+// Answers packets until the client resumes the CPU or disconnects
+static void Serve(Debugger *dbg, State8080 *state)
+{
+    char in[MAX_PACKET], out[MAX_PACKET * 2];
+
+    while (dbg->fd >= 0 && dbg->stopped) {
+        int n = GetPacket(dbg, in);
+        if (n == -1) {
+            Disconnect(dbg);
+            return;
+        }
+        if (n == -2)
+            continue;   // already stopped
+
+        const char *p = in + 1;
+        char *o = out;
+        out[0] = '\0';
+        switch (in[0]) {
+            case '?':
+                strcpy(out, dbg->stop_reason);
+                break;
+            case 'g':
+                for (int r = 0; r < DEBUG_NUM_REGS; r++)
+                    o = PutRegister(o, state, r);
+                *o = '\0';
+                break;
+            case 'G':
+                for (int r = 0; r < DEBUG_NUM_REGS; r++)
+                    SetRegister(state, r, ParseRegister(&p, r));
+                strcpy(out, "OK");
+                break;
+            case 'p':
+            {
+                unsigned r = ParseHex(&p);
+                if (r < DEBUG_NUM_REGS) {
+                    o = PutRegister(o, state, r);
+                    *o = '\0';
+                } else {
+                    strcpy(out, "E01");
+                }
+            }
+                break;
+            case 'P':
+            {
+                unsigned r = ParseHex(&p);
+                if (*p++ == '=' && r < DEBUG_NUM_REGS) {
+                    SetRegister(state, r, ParseRegister(&p, r));
+                    strcpy(out, "OK");
+                } else {
+                    strcpy(out, "E01");
+                }
+            }
+                break;
+            case 'm':
+            {
+                uint16_t addr = ParseHex(&p);
+                unsigned len = (*p++ == ',') ? ParseHex(&p) : 0;
+                if (len > MAX_PACKET / 2)
+                    len = MAX_PACKET / 2;
+                for (unsigned i = 0; i < len; i++)
+                    o = PutHexByte(o, MemRead(state, addr + i));
+                *o = '\0';
+            }
+                break;
+            case 'M':
+            {
+                uint16_t addr = ParseHex(&p);
+                unsigned len = (*p++ == ',') ? ParseHex(&p) : 0;
+                if (*p++ != ':') {
+                    strcpy(out, "E01");
+                    break;
+                }
+                // Goes through the read map so that ROM can be patched too
+                for (unsigned i = 0; i < len && p[0] && p[1]; i++, p += 2) {
+                    uint16_t a = addr + i;
+                    uint32_t offset = state->map->read[a >> 8] | (a & 0xff);
+                    state->memory[offset] = HexValue(p[0]) << 4 | HexValue(p[1]);
+                    state->map->dirty[offset >> 8] = DIRTY_ALL;
+                }
+                strcpy(out, "OK");
+            }
+                break;
+            case 'c':
+            case 's':
+                if (*p)
+                    state->pc = ParseHex(&p);
+                dbg->stepping = (in[0] == 's');
+                dbg->resume_pc = state->pc;
+                dbg->stopped = 0;
+                UpdateArmed(dbg);
+                return;
+            case 'Z':
+            case 'z':
+            {
+                int type = (int) ParseHex(&p);
+                uint16_t addr = (*p++ == ',') ? ParseHex(&p) : 0;
+                int len = (*p++ == ',') ? (int) ParseHex(&p) : 1;
+                if (type > 4) {
+                    out[0] = '\0';
+                    break;
+                }
+                SetPoint(dbg, type, addr, len, in[0] == 'Z');
+                strcpy(out, "OK");
+            }
+                break;
+            case 'k':
+                printf("debugger killed the emulator\n");
+                exit(0);
+            case 'D':
+                PutPacket(dbg, "OK");
+                Disconnect(dbg);
+                return;
+            case 'q':
+                if (strncmp(in, "qSupported", 10) == 0)
+                    snprintf(out, sizeof(out), "PacketSize=%x;swbreak+;hwbreak+", MAX_PACKET);
+                else if (strcmp(in, "qAttached") == 0)
+                    strcpy(out, "1");
+                else if (strncmp(in, "qRcmd,", 6) == 0) {
+                    Monitor(dbg, state, in + 6);
+                    continue;
+                }
+                break;
+            default:
+                break;  // empty reply: unsupported
+        }
+        PutPacket(dbg, out);
+    }
+}
+
+static void Stop(Debugger *dbg, State8080 *state, const char *reason)
+{
+    dbg->stopped = 1;
+    dbg->stepping = 0;
+    snprintf(dbg->stop_reason, sizeof(dbg->stop_reason), "%s", reason);
+    UpdateArmed(dbg);
+    PutPacket(dbg, reason);
+    Serve(dbg, state);
+}
+
+// Called between run slices: serves a stopped CPU and notices a Ctrl-C
+// from the client while the CPU runs unarmed.
+void DebugPoll(Debugger *dbg, State8080 *state) {
+    if (dbg->fd < 0)
+        return;
+    if (dbg->stopped) {
+        Serve(dbg, state);
+        return;
+    }
+    struct pollfd pfd = {dbg->fd, POLLIN, 0};
+    if (poll(&pfd, 1, 0) <= 0)
+        return;
+    char in[MAX_PACKET];
+    int n = GetPacket(dbg, in);
+    if (n == -1)
+        Disconnect(dbg);
+    else if (n == -2)
+        Stop(dbg, state, "S02");
+    else
+        PutPacket(dbg, "");     // the CPU is running; nothing else is accepted
+}
+
+// Condition of a conditional call/return/jump opcode
+static int Condition(const State8080 *state, uint8_t op)
+{
+    switch ((op >> 3) & 7) {
+        case 0: return !state->cc.z;
+        case 1: return state->cc.z;
+        case 2: return !state->cc.cy;
+        case 3: return state->cc.cy;
+        case 4: return !state->cc.p;
+        case 5: return state->cc.p;
+        case 6: return !state->cc.s;
+        default: return state->cc.s;
+    }
+}
+
+// Memory the instruction at pc is about to read and write
+static void Accesses(const State8080 *state, int *raddr, int *rlen, int *waddr, int *wlen)
+{
+    uint8_t code[3] = {MemRead(state, state->pc), MemRead(state, state->pc + 1), MemRead(state, state->pc + 2)};
+    uint8_t op = code[0];
+    uint16_t hl = state->hl;
+    uint16_t direct = code[1] | code[2] << 8;
+
+    *rlen = *wlen = 0;
+    *raddr = *waddr = 0;
+    if ((op >= 0x40 && op <= 0x7f && (op & 7) == 6 && op != 0x76) || (op >= 0x80 && op <= 0xbf && (op & 7) == 6)) {
+        *raddr = hl; *rlen = 1;
+    } else if (op >= 0x70 && op <= 0x77 && op != 0x76) {
+        *waddr = hl; *wlen = 1;
+    } else if (op == 0x34 || op == 0x35) {
+        *raddr = *waddr = hl; *rlen = *wlen = 1;
+    } else if (op == 0x36) {
+        *waddr = hl; *wlen = 1;
+    } else if (op == 0x0a || op == 0x02) {
+        *(op == 0x0a ? raddr : waddr) = state->bc;
+        *(op == 0x0a ? rlen : wlen) = 1;
+    } else if (op == 0x1a || op == 0x12) {
+        *(op == 0x1a ? raddr : waddr) = state->de;
+        *(op == 0x1a ? rlen : wlen) = 1;
+    } else if (op == 0x3a || op == 0x2a) {
+        *raddr = direct; *rlen = (op == 0x2a) ? 2 : 1;
+    } else if (op == 0x32 || op == 0x22) {
+        *waddr = direct; *wlen = (op == 0x22) ? 2 : 1;
+    } else if ((op & 0xcf) == 0xc1 || op == 0xc9 || ((op & 0xc7) == 0xc0 && Condition(state, op))) {
+        *raddr = state->sp; *rlen = 2;          // POP, RET, taken Rcc
+    } else if ((op & 0xcf) == 0xc5 || op == 0xcd || (op & 0xc7) == 0xc7 ||
+               ((op & 0xc7) == 0xc4 && Condition(state, op))) {
+        *waddr = (uint16_t) (state->sp - 2); *wlen = 2;     // PUSH, CALL, RST, taken Ccc
+    } else if (op == 0xe3) {
+        *raddr = *waddr = state->sp; *rlen = *wlen = 2;     // XTHL
+    }
+}
+
+static int Watched(const uint8_t *bitmap, int addr, int len)
+{
+    for (int i = 0; i < len; i++) {
+        if (DebugBit(bitmap, (uint16_t) (addr + i)))
+            return 1;
+    }
+    return 0;
+}
+
+// Single-steps the CPU while breakpoints, watchpoints or stepping are
+// active. Watchpoints stop after the instruction that touched the memory.
+void DebugRun(Debugger *dbg, State8080 *state, uint64_t until) {
+    char reason[32];
+
+    while (state->cycles < until && dbg->armed) {
+        if (state->halted) {
+            if (state->int_enable)
+                state->cycles = until;
+            break;
+        }
+        uint16_t pc = state->pc;
+        if (pc != dbg->resume_pc && (DebugBit(dbg->breakpoints, pc) || pc == dbg->run_to)) {
+            if (pc == dbg->run_to)
+                dbg->run_to = -1;
+            dbg->resume_pc = -1;
+            Stop(dbg, state, "T05swbreak:;");
+            continue;
+        }
+        dbg->resume_pc = -1;
+
+        int raddr, rlen, waddr, wlen;
+        reason[0] = '\0';
+        if (dbg->num_watchpoints) {
+            Accesses(state, &raddr, &rlen, &waddr, &wlen);
+            if (Watched(dbg->watch_write, waddr, wlen))
+                snprintf(reason, sizeof(reason), "T05watch:%x;", waddr);
+            else if (Watched(dbg->watch_access, waddr, wlen))
+                snprintf(reason, sizeof(reason), "T05awatch:%x;", waddr);
+            else if (Watched(dbg->watch_read, raddr, rlen))
+                snprintf(reason, sizeof(reason), "T05rwatch:%x;", raddr);
+            else if (Watched(dbg->watch_access, raddr, rlen))
+                snprintf(reason, sizeof(reason), "T05awatch:%x;", raddr);
+        }
+
+        Emulate8080Op(state);
+
+        if (reason[0])
+            Stop(dbg, state, reason);
+        else if (dbg->stepping)
+            Stop(dbg, state, "S05");
+    }
+}
@@ -0,0 +1,43 @@
+#ifndef DEBUG_H
+#define DEBUG_H
+
+#include <stdint.h>
+#include "cpu8080.h"
+
+// Debugger speaking the GDB remote serial protocol over a local TCP port
+// or a Unix socket. Breakpoints and watchpoints are per-address bitmaps.
+// They are only consulted while the debugger is armed, so with nothing
+// set the frontend keeps using the normal run loops.
+//
+// Registers for the g/G/p/P packets, in order: A, PSW flags, B, C, D,
+// E, H, L (one byte each), then SP and PC (two bytes each, little endian).
+
+#define DEBUG_NUM_REGS 10
+
+typedef struct Debugger {
+    uint8_t breakpoints[0x10000 / 8];
+    uint8_t watch_read[0x10000 / 8];
+    uint8_t watch_write[0x10000 / 8];
+    uint8_t watch_access[0x10000 / 8];  // Z4, stops on reads and writes
+    int num_breakpoints;
+    int num_watchpoints;
+    int armed;
+    int stopped;
+    int stepping;
+    int resume_pc;          // breakpoint at this pc is skipped once on resume
+    int run_to;             // temporary breakpoint from "monitor runto", or -1
+    int listen_fd;
+    int fd;
+    char stop_reason[32];
+} Debugger;
+
+Debugger *DebugCreate(const char *address);
+void DebugPoll(Debugger *dbg, State8080 *state);
+void DebugRun(Debugger *dbg, State8080 *state, uint64_t until);
+
+static inline int DebugBit(const uint8_t *bitmap, uint16_t addr)
+{
+    return (bitmap[addr >> 3] >> (addr & 7)) & 1;
+}
+
+#endif
@@ -0,0 +1,94 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "disasm.h"
+#include "pacing.h"
+
+// Whole-ROM disassembler. Loads files at the given offsets, traces code
+// from the reset and RST vectors and prints a labelled listing.
+//
+//   dis8080 [-linear] [-time] file@offset ...
+//
+// The default loads the four Space Invaders ROMs.
+
+static const char *const invaders[] = {
+    "invaders.h@0", "invaders.g@800", "invaders.f@1000", "invaders.e@1800",
+};
+
+static uint8_t memory[0x10000];
+static Listing listing;
+
+static uint32_t Load(const char *spec)
+{
+    char name[1024];
+    const char *at = strrchr(spec, '@');
+    uint32_t offset = at ? (uint32_t) strtoul(at + 1, NULL, 16) : 0;
+    size_t len = at ? (size_t) (at - spec) : strlen(spec);
+    if (len >= sizeof(name))
+        len = sizeof(name) - 1;
+    memcpy(name, spec, len);
+    name[len] = '\0';
+
+    FILE *f = fopen(name, "rb");
+    if (f == NULL) {
+        printf("error: Couldn't open %s\n", name);
+        exit(1);
+    }
+    size_t n = fread(&memory[offset & 0xffff], 1, 0x10000 - (offset & 0xffff), f);
+    fclose(f);
+    return (offset & 0xffff) + n;
+}
+
+static void Analyze(uint32_t end, int linear)
+{
+    ListingInit(&listing, 0, end);
+    for (int rst = 0; rst < 8; rst++)
+        ListingTrace(&listing, memory, rst * 8);
+    if (linear)
+        ListingSweep(&listing, memory);
+}
+
+int main(int argc, char **argv) {
+    int linear = 0, timing = 0, nfiles = 0;
+    uint32_t end = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-linear") == 0) {
+            linear = 1;
+        } else if (strcmp(argv[i], "-time") == 0) {
+            timing = 1;
+        } else {
+            uint32_t e = Load(argv[i]);
+            end = e > end ? e : end;
+            nfiles++;
+        }
+    }
+    if (nfiles == 0) {
+        for (size_t i = 0; i < sizeof(invaders) / sizeof(invaders[0]); i++) {
+            uint32_t e = Load(invaders[i]);
+            end = e > end ? e : end;
+        }
+    }
+
+    size_t size = 64 * end + 4096;
+    char *text = malloc(size);
+    Analyze(end, linear);
+    size_t n = ListingFormat(&listing, memory, text, size);
+
+    if (timing) {
+        const int passes = 1000;
+        uint64_t t0 = PacerNow();
+        for (int i = 0; i < passes; i++)
+            Analyze(end, linear);
+        uint64_t t1 = PacerNow();
+        for (int i = 0; i < passes; i++)
+            ListingFormat(&listing, memory, text, size);
+        uint64_t t2 = PacerNow();
+        printf("%u bytes: analysis %.1f us, listing %.1f us (%zu bytes of text)\n", end,
+               (t1 - t0) / 1000.0 / passes, (t2 - t1) / 1000.0 / passes, n);
+    } else {
+        fwrite(text, 1, n < size ? n : size, stdout);
+    }
+    free(text);
+    return 0;
+}
@@ -0,0 +1,528 @@
+#include <stdio.h>
+#include <string.h>
+#include "disasm.h"
+#include "cpu8080.h"
+
+typedef struct OpInfo {
+    uint8_t mnemonic;
+    uint8_t operand[2];     // kind << 4 | value
+    uint8_t flow;
+} OpInfo;
+
+#define O_SPEC(kind, value) ((kind) << 4 | (value))
+#define O_NONE      O_SPEC(OPND_NONE, 0)
+#define O_REG(r)    O_SPEC(OPND_REG, r)
+#define O_PAIR_B    O_SPEC(OPND_PAIR, 0)
+#define O_PAIR_D    O_SPEC(OPND_PAIR, 1)
+#define O_PAIR_H    O_SPEC(OPND_PAIR, 2)
+#define O_PAIR_SP   O_SPEC(OPND_PAIR, 3)
+#define O_PAIR_PSW  O_SPEC(OPND_PAIR, 4)
+#define O_IMM8      O_SPEC(OPND_IMM8, 0)
+#define O_IMM16     O_SPEC(OPND_IMM16, 0)
+#define O_ADDR      O_SPEC(OPND_ADDR, 0)
+#define O_PORT      O_SPEC(OPND_PORT, 0)
+#define O_RST(n)    O_SPEC(OPND_RST, n)
+
+static const OpInfo ops[256] = {
+    {MN_NOP,  {O_NONE,     O_NONE},  FLOW_NEXT},    // 00
+    {MN_LXI,  {O_PAIR_B,   O_IMM16}, FLOW_NEXT},    // 01
+    {MN_STAX, {O_PAIR_B,   O_NONE},  FLOW_NEXT},    // 02
+    {MN_INX,  {O_PAIR_B,   O_NONE},  FLOW_NEXT},    // 03
+    {MN_INR,  {O_REG(0),   O_NONE},  FLOW_NEXT},    // 04
+    {MN_DCR,  {O_REG(0),   O_NONE},  FLOW_NEXT},    // 05
+    {MN_MVI,  {O_REG(0),   O_IMM8},  FLOW_NEXT},    // 06
+    {MN_RLC,  {O_NONE,     O_NONE},  FLOW_NEXT},    // 07
+    {MN_NOP,  {O_NONE,     O_NONE},  FLOW_NEXT},    // 08
+    {MN_DAD,  {O_PAIR_B,   O_NONE},  FLOW_NEXT},    // 09
+    {MN_LDAX, {O_PAIR_B,   O_NONE},  FLOW_NEXT},    // 0a
+    {MN_DCX,  {O_PAIR_B,   O_NONE},  FLOW_NEXT},    // 0b
+    {MN_INR,  {O_REG(1),   O_NONE},  FLOW_NEXT},    // 0c
+    {MN_DCR,  {O_REG(1),   O_NONE},  FLOW_NEXT},    // 0d
+    {MN_MVI,  {O_REG(1),   O_IMM8},  FLOW_NEXT},    // 0e
+    {MN_RRC,  {O_NONE,     O_NONE},  FLOW_NEXT},    // 0f
+    {MN_NOP,  {O_NONE,     O_NONE},  FLOW_NEXT},    // 10
+    {MN_LXI,  {O_PAIR_D,   O_IMM16}, FLOW_NEXT},    // 11
+    {MN_STAX, {O_PAIR_D,   O_NONE},  FLOW_NEXT},    // 12
+    {MN_INX,  {O_PAIR_D,   O_NONE},  FLOW_NEXT},    // 13
+    {MN_INR,  {O_REG(2),   O_NONE},  FLOW_NEXT},    // 14
+    {MN_DCR,  {O_REG(2),   O_NONE},  FLOW_NEXT},    // 15
+    {MN_MVI,  {O_REG(2),   O_IMM8},  FLOW_NEXT},    // 16
+    {MN_RAL,  {O_NONE,     O_NONE},  FLOW_NEXT},    // 17
+    {MN_NOP,  {O_NONE,     O_NONE},  FLOW_NEXT},    // 18
+    {MN_DAD,  {O_PAIR_D,   O_NONE},  FLOW_NEXT},    // 19
+    {MN_LDAX, {O_PAIR_D,   O_NONE},  FLOW_NEXT},    // 1a
+    {MN_DCX,  {O_PAIR_D,   O_NONE},  FLOW_NEXT},    // 1b
+    {MN_INR,  {O_REG(3),   O_NONE},  FLOW_NEXT},    // 1c
+    {MN_DCR,  {O_REG(3),   O_NONE},  FLOW_NEXT},    // 1d
+    {MN_MVI,  {O_REG(3),   O_IMM8},  FLOW_NEXT},    // 1e
+    {MN_RAR,  {O_NONE,     O_NONE},  FLOW_NEXT},    // 1f
+    {MN_NOP,  {O_NONE,     O_NONE},  FLOW_NEXT},    // 20
+    {MN_LXI,  {O_PAIR_H,   O_IMM16}, FLOW_NEXT},    // 21
+    {MN_SHLD, {O_ADDR,     O_NONE},  FLOW_NEXT},    // 22
+    {MN_INX,  {O_PAIR_H,   O_NONE},  FLOW_NEXT},    // 23
+    {MN_INR,  {O_REG(4),   O_NONE},  FLOW_NEXT},    // 24
+    {MN_DCR,  {O_REG(4),   O_NONE},  FLOW_NEXT},    // 25
+    {MN_MVI,  {O_REG(4),   O_IMM8},  FLOW_NEXT},    // 26
+    {MN_DAA,  {O_NONE,     O_NONE},  FLOW_NEXT},    // 27
+    {MN_NOP,  {O_NONE,     O_NONE},  FLOW_NEXT},    // 28
+    {MN_DAD,  {O_PAIR_H,   O_NONE},  FLOW_NEXT},    // 29
+    {MN_LHLD, {O_ADDR,     O_NONE},  FLOW_NEXT},    // 2a
+    {MN_DCX,  {O_PAIR_H,   O_NONE},  FLOW_NEXT},    // 2b
+    {MN_INR,  {O_REG(5),   O_NONE},  FLOW_NEXT},    // 2c
+    {MN_DCR,  {O_REG(5),   O_NONE},  FLOW_NEXT},    // 2d
+    {MN_MVI,  {O_REG(5),   O_IMM8},  FLOW_NEXT},    // 2e
+    {MN_CMA,  {O_NONE,     O_NONE},  FLOW_NEXT},    // 2f
+    {MN_NOP,  {O_NONE,     O_NONE},  FLOW_NEXT},    // 30
+    {MN_LXI,  {O_PAIR_SP,  O_IMM16}, FLOW_NEXT},    // 31
+    {MN_STA,  {O_ADDR,     O_NONE},  FLOW_NEXT},    // 32
+    {MN_INX,  {O_PAIR_SP,  O_NONE},  FLOW_NEXT},    // 33
+    {MN_INR,  {O_REG(6),   O_NONE},  FLOW_NEXT},    // 34
+    {MN_DCR,  {O_REG(6),   O_NONE},  FLOW_NEXT},    // 35
+    {MN_MVI,  {O_REG(6),   O_IMM8},  FLOW_NEXT},    // 36
+    {MN_STC,  {O_NONE,     O_NONE},  FLOW_NEXT},    // 37
+    {MN_NOP,  {O_NONE,     O_NONE},  FLOW_NEXT},    // 38
+    {MN_DAD,  {O_PAIR_SP,  O_NONE},  FLOW_NEXT},    // 39
+    {MN_LDA,  {O_ADDR,     O_NONE},  FLOW_NEXT},    // 3a
+    {MN_DCX,  {O_PAIR_SP,  O_NONE},  FLOW_NEXT},    // 3b
+    {MN_INR,  {O_REG(7),   O_NONE},  FLOW_NEXT},    // 3c
+    {MN_DCR,  {O_REG(7),   O_NONE},  FLOW_NEXT},    // 3d
+    {MN_MVI,  {O_REG(7),   O_IMM8},  FLOW_NEXT},    // 3e
+    {MN_CMC,  {O_NONE,     O_NONE},  FLOW_NEXT},    // 3f
+    {MN_MOV,  {O_REG(0),   O_REG(0)}, FLOW_NEXT},    // 40
+    {MN_MOV,  {O_REG(0),   O_REG(1)}, FLOW_NEXT},    // 41
+    {MN_MOV,  {O_REG(0),   O_REG(2)}, FLOW_NEXT},    // 42
+    {MN_MOV,  {O_REG(0),   O_REG(3)}, FLOW_NEXT},    // 43
+    {MN_MOV,  {O_REG(0),   O_REG(4)}, FLOW_NEXT},    // 44
+    {MN_MOV,  {O_REG(0),   O_REG(5)}, FLOW_NEXT},    // 45
+    {MN_MOV,  {O_REG(0),   O_REG(6)}, FLOW_NEXT},    // 46
+    {MN_MOV,  {O_REG(0),   O_REG(7)}, FLOW_NEXT},    // 47
+    {MN_MOV,  {O_REG(1),   O_REG(0)}, FLOW_NEXT},    // 48
+    {MN_MOV,  {O_REG(1),   O_REG(1)}, FLOW_NEXT},    // 49
+    {MN_MOV,  {O_REG(1),   O_REG(2)}, FLOW_NEXT},    // 4a
+    {MN_MOV,  {O_REG(1),   O_REG(3)}, FLOW_NEXT},    // 4b
+    {MN_MOV,  {O_REG(1),   O_REG(4)}, FLOW_NEXT},    // 4c
+    {MN_MOV,  {O_REG(1),   O_REG(5)}, FLOW_NEXT},    // 4d
+    {MN_MOV,  {O_REG(1),   O_REG(6)}, FLOW_NEXT},    // 4e
+    {MN_MOV,  {O_REG(1),   O_REG(7)}, FLOW_NEXT},    // 4f
+    {MN_MOV,  {O_REG(2),   O_REG(0)}, FLOW_NEXT},    // 50
+    {MN_MOV,  {O_REG(2),   O_REG(1)}, FLOW_NEXT},    // 51
+    {MN_MOV,  {O_REG(2),   O_REG(2)}, FLOW_NEXT},    // 52
+    {MN_MOV,  {O_REG(2),   O_REG(3)}, FLOW_NEXT},    // 53
+    {MN_MOV,  {O_REG(2),   O_REG(4)}, FLOW_NEXT},    // 54
+    {MN_MOV,  {O_REG(2),   O_REG(5)}, FLOW_NEXT},    // 55
+    {MN_MOV,  {O_REG(2),   O_REG(6)}, FLOW_NEXT},    // 56
+    {MN_MOV,  {O_REG(2),   O_REG(7)}, FLOW_NEXT},    // 57
+    {MN_MOV,  {O_REG(3),   O_REG(0)}, FLOW_NEXT},    // 58
+    {MN_MOV,  {O_REG(3),   O_REG(1)}, FLOW_NEXT},    // 59
+    {MN_MOV,  {O_REG(3),   O_REG(2)}, FLOW_NEXT},    // 5a
+    {MN_MOV,  {O_REG(3),   O_REG(3)}, FLOW_NEXT},    // 5b
+    {MN_MOV,  {O_REG(3),   O_REG(4)}, FLOW_NEXT},    // 5c
+    {MN_MOV,  {O_REG(3),   O_REG(5)}, FLOW_NEXT},    // 5d
+    {MN_MOV,  {O_REG(3),   O_REG(6)}, FLOW_NEXT},    // 5e
+    {MN_MOV,  {O_REG(3),   O_REG(7)}, FLOW_NEXT},    // 5f
+    {MN_MOV,  {O_REG(4),   O_REG(0)}, FLOW_NEXT},    // 60
+    {MN_MOV,  {O_REG(4),   O_REG(1)}, FLOW_NEXT},    // 61
+    {MN_MOV,  {O_REG(4),   O_REG(2)}, FLOW_NEXT},    // 62
+    {MN_MOV,  {O_REG(4),   O_REG(3)}, FLOW_NEXT},    // 63
+    {MN_MOV,  {O_REG(4),   O_REG(4)}, FLOW_NEXT},    // 64
+    {MN_MOV,  {O_REG(4),   O_REG(5)}, FLOW_NEXT},    // 65
+    {MN_MOV,  {O_REG(4),   O_REG(6)}, FLOW_NEXT},    // 66
+    {MN_MOV,  {O_REG(4),   O_REG(7)}, FLOW_NEXT},    // 67
+    {MN_MOV,  {O_REG(5),   O_REG(0)}, FLOW_NEXT},    // 68
+    {MN_MOV,  {O_REG(5),   O_REG(1)}, FLOW_NEXT},    // 69
+    {MN_MOV,  {O_REG(5),   O_REG(2)}, FLOW_NEXT},    // 6a
+    {MN_MOV,  {O_REG(5),   O_REG(3)}, FLOW_NEXT},    // 6b
+    {MN_MOV,  {O_REG(5),   O_REG(4)}, FLOW_NEXT},    // 6c
+    {MN_MOV,  {O_REG(5),   O_REG(5)}, FLOW_NEXT},    // 6d
+    {MN_MOV,  {O_REG(5),   O_REG(6)}, FLOW_NEXT},    // 6e
+    {MN_MOV,  {O_REG(5),   O_REG(7)}, FLOW_NEXT},    // 6f
+    {MN_MOV,  {O_REG(6),   O_REG(0)}, FLOW_NEXT},    // 70
+    {MN_MOV,  {O_REG(6),   O_REG(1)}, FLOW_NEXT},    // 71
+    {MN_MOV,  {O_REG(6),   O_REG(2)}, FLOW_NEXT},    // 72
+    {MN_MOV,  {O_REG(6),   O_REG(3)}, FLOW_NEXT},    // 73
+    {MN_MOV,  {O_REG(6),   O_REG(4)}, FLOW_NEXT},    // 74
+    {MN_MOV,  {O_REG(6),   O_REG(5)}, FLOW_NEXT},    // 75
+    {MN_HLT,  {O_NONE,     O_NONE},  FLOW_HALT},    // 76
+    {MN_MOV,  {O_REG(6),   O_REG(7)}, FLOW_NEXT},    // 77
+    {MN_MOV,  {O_REG(7),   O_REG(0)}, FLOW_NEXT},    // 78
+    {MN_MOV,  {O_REG(7),   O_REG(1)}, FLOW_NEXT},    // 79
+    {MN_MOV,  {O_REG(7),   O_REG(2)}, FLOW_NEXT},    // 7a
+    {MN_MOV,  {O_REG(7),   O_REG(3)}, FLOW_NEXT},    // 7b
+    {MN_MOV,  {O_REG(7),   O_REG(4)}, FLOW_NEXT},    // 7c
+    {MN_MOV,  {O_REG(7),   O_REG(5)}, FLOW_NEXT},    // 7d
+    {MN_MOV,  {O_REG(7),   O_REG(6)}, FLOW_NEXT},    // 7e
+    {MN_MOV,  {O_REG(7),   O_REG(7)}, FLOW_NEXT},    // 7f
+    {MN_ADD,  {O_REG(0),   O_NONE},  FLOW_NEXT},    // 80
+    {MN_ADD,  {O_REG(1),   O_NONE},  FLOW_NEXT},    // 81
+    {MN_ADD,  {O_REG(2),   O_NONE},  FLOW_NEXT},    // 82
+    {MN_ADD,  {O_REG(3),   O_NONE},  FLOW_NEXT},    // 83
+    {MN_ADD,  {O_REG(4),   O_NONE},  FLOW_NEXT},    // 84
+    {MN_ADD,  {O_REG(5),   O_NONE},  FLOW_NEXT},    // 85
+    {MN_ADD,  {O_REG(6),   O_NONE},  FLOW_NEXT},    // 86
+    {MN_ADD,  {O_REG(7),   O_NONE},  FLOW_NEXT},    // 87
+    {MN_ADC,  {O_REG(0),   O_NONE},  FLOW_NEXT},    // 88
+    {MN_ADC,  {O_REG(1),   O_NONE},  FLOW_NEXT},    // 89
+    {MN_ADC,  {O_REG(2),   O_NONE},  FLOW_NEXT},    // 8a
+    {MN_ADC,  {O_REG(3),   O_NONE},  FLOW_NEXT},    // 8b
+    {MN_ADC,  {O_REG(4),   O_NONE},  FLOW_NEXT},    // 8c
+    {MN_ADC,  {O_REG(5),   O_NONE},  FLOW_NEXT},    // 8d
+    {MN_ADC,  {O_REG(6),   O_NONE},  FLOW_NEXT},    // 8e
+    {MN_ADC,  {O_REG(7),   O_NONE},  FLOW_NEXT},    // 8f
+    {MN_SUB,  {O_REG(0),   O_NONE},  FLOW_NEXT},    // 90
+    {MN_SUB,  {O_REG(1),   O_NONE},  FLOW_NEXT},    // 91
+    {MN_SUB,  {O_REG(2),   O_NONE},  FLOW_NEXT},    // 92
+    {MN_SUB,  {O_REG(3),   O_NONE},  FLOW_NEXT},    // 93
+    {MN_SUB,  {O_REG(4),   O_NONE},  FLOW_NEXT},    // 94
+    {MN_SUB,  {O_REG(5),   O_NONE},  FLOW_NEXT},    // 95
+    {MN_SUB,  {O_REG(6),   O_NONE},  FLOW_NEXT},    // 96
+    {MN_SUB,  {O_REG(7),   O_NONE},  FLOW_NEXT},    // 97
+    {MN_SBB,  {O_REG(0),   O_NONE},  FLOW_NEXT},    // 98
+    {MN_SBB,  {O_REG(1),   O_NONE},  FLOW_NEXT},    // 99
+    {MN_SBB,  {O_REG(2),   O_NONE},  FLOW_NEXT},    // 9a
+    {MN_SBB,  {O_REG(3),   O_NONE},  FLOW_NEXT},    // 9b
+    {MN_SBB,  {O_REG(4),   O_NONE},  FLOW_NEXT},    // 9c
+    {MN_SBB,  {O_REG(5),   O_NONE},  FLOW_NEXT},    // 9d
+    {MN_SBB,  {O_REG(6),   O_NONE},  FLOW_NEXT},    // 9e
+    {MN_SBB,  {O_REG(7),   O_NONE},  FLOW_NEXT},    // 9f
+    {MN_ANA,  {O_REG(0),   O_NONE},  FLOW_NEXT},    // a0
+    {MN_ANA,  {O_REG(1),   O_NONE},  FLOW_NEXT},    // a1
+    {MN_ANA,  {O_REG(2),   O_NONE},  FLOW_NEXT},    // a2
+    {MN_ANA,  {O_REG(3),   O_NONE},  FLOW_NEXT},    // a3
+    {MN_ANA,  {O_REG(4),   O_NONE},  FLOW_NEXT},    // a4
+    {MN_ANA,  {O_REG(5),   O_NONE},  FLOW_NEXT},    // a5
+    {MN_ANA,  {O_REG(6),   O_NONE},  FLOW_NEXT},    // a6
+    {MN_ANA,  {O_REG(7),   O_NONE},  FLOW_NEXT},    // a7
+    {MN_XRA,  {O_REG(0),   O_NONE},  FLOW_NEXT},    // a8
+    {MN_XRA,  {O_REG(1),   O_NONE},  FLOW_NEXT},    // a9
+    {MN_XRA,  {O_REG(2),   O_NONE},  FLOW_NEXT},    // aa
+    {MN_XRA,  {O_REG(3),   O_NONE},  FLOW_NEXT},    // ab
+    {MN_XRA,  {O_REG(4),   O_NONE},  FLOW_NEXT},    // ac
+    {MN_XRA,  {O_REG(5),   O_NONE},  FLOW_NEXT},    // ad
+    {MN_XRA,  {O_REG(6),   O_NONE},  FLOW_NEXT},    // ae
+    {MN_XRA,  {O_REG(7),   O_NONE},  FLOW_NEXT},    // af
+    {MN_ORA,  {O_REG(0),   O_NONE},  FLOW_NEXT},    // b0
+    {MN_ORA,  {O_REG(1),   O_NONE},  FLOW_NEXT},    // b1
+    {MN_ORA,  {O_REG(2),   O_NONE},  FLOW_NEXT},    // b2
+    {MN_ORA,  {O_REG(3),   O_NONE},  FLOW_NEXT},    // b3
+    {MN_ORA,  {O_REG(4),   O_NONE},  FLOW_NEXT},    // b4
+    {MN_ORA,  {O_REG(5),   O_NONE},  FLOW_NEXT},    // b5
+    {MN_ORA,  {O_REG(6),   O_NONE},  FLOW_NEXT},    // b6
+    {MN_ORA,  {O_REG(7),   O_NONE},  FLOW_NEXT},    // b7
+    {MN_CMP,  {O_REG(0),   O_NONE},  FLOW_NEXT},    // b8
+    {MN_CMP,  {O_REG(1),   O_NONE},  FLOW_NEXT},    // b9
+    {MN_CMP,  {O_REG(2),   O_NONE},  FLOW_NEXT},    // ba
+    {MN_CMP,  {O_REG(3),   O_NONE},  FLOW_NEXT},    // bb
+    {MN_CMP,  {O_REG(4),   O_NONE},  FLOW_NEXT},    // bc
+    {MN_CMP,  {O_REG(5),   O_NONE},  FLOW_NEXT},    // bd
+    {MN_CMP,  {O_REG(6),   O_NONE},  FLOW_NEXT},    // be
+    {MN_CMP,  {O_REG(7),   O_NONE},  FLOW_NEXT},    // bf
+    {MN_RNZ,  {O_NONE,     O_NONE},  FLOW_CRET},    // c0
+    {MN_POP,  {O_PAIR_B,   O_NONE},  FLOW_NEXT},    // c1
+    {MN_JNZ,  {O_ADDR,     O_NONE},  FLOW_CJUMP},   // c2
+    {MN_JMP,  {O_ADDR,     O_NONE},  FLOW_JUMP},    // c3
+    {MN_CNZ,  {O_ADDR,     O_NONE},  FLOW_CCALL},   // c4
+    {MN_PUSH, {O_PAIR_B,   O_NONE},  FLOW_NEXT},    // c5
+    {MN_ADI,  {O_IMM8,     O_NONE},  FLOW_NEXT},    // c6
+    {MN_RST,  {O_RST(0),   O_NONE},  FLOW_CALL},    // c7
+    {MN_RZ,   {O_NONE,     O_NONE},  FLOW_CRET},    // c8
+    {MN_RET,  {O_NONE,     O_NONE},  FLOW_RET},     // c9
+    {MN_JZ,   {O_ADDR,     O_NONE},  FLOW_CJUMP},   // ca
+    {MN_JMP,  {O_ADDR,     O_NONE},  FLOW_JUMP},    // cb
+    {MN_CZ,   {O_ADDR,     O_NONE},  FLOW_CCALL},   // cc
+    {MN_CALL, {O_ADDR,     O_NONE},  FLOW_CALL},    // cd
+    {MN_ACI,  {O_IMM8,     O_NONE},  FLOW_NEXT},    // ce
+    {MN_RST,  {O_RST(1),   O_NONE},  FLOW_CALL},    // cf
+    {MN_RNC,  {O_NONE,     O_NONE},  FLOW_CRET},    // d0
+    {MN_POP,  {O_PAIR_D,   O_NONE},  FLOW_NEXT},    // d1
+    {MN_JNC,  {O_ADDR,     O_NONE},  FLOW_CJUMP},   // d2
+    {MN_OUT,  {O_PORT,     O_NONE},  FLOW_NEXT},    // d3
+    {MN_CNC,  {O_ADDR,     O_NONE},  FLOW_CCALL},   // d4
+    {MN_PUSH, {O_PAIR_D,   O_NONE},  FLOW_NEXT},    // d5
+    {MN_SUI,  {O_IMM8,     O_NONE},  FLOW_NEXT},    // d6
+    {MN_RST,  {O_RST(2),   O_NONE},  FLOW_CALL},    // d7
+    {MN_RC,   {O_NONE,     O_NONE},  FLOW_CRET},    // d8
+    {MN_RET,  {O_NONE,     O_NONE},  FLOW_RET},     // d9
+    {MN_JC,   {O_ADDR,     O_NONE},  FLOW_CJUMP},   // da
+    {MN_IN,   {O_PORT,     O_NONE},  FLOW_NEXT},    // db
+    {MN_CC,   {O_ADDR,     O_NONE},  FLOW_CCALL},   // dc
+    {MN_CALL, {O_ADDR,     O_NONE},  FLOW_CALL},    // dd
+    {MN_SBI,  {O_IMM8,     O_NONE},  FLOW_NEXT},    // de
+    {MN_RST,  {O_RST(3),   O_NONE},  FLOW_CALL},    // df
+    {MN_RPO,  {O_NONE,     O_NONE},  FLOW_CRET},    // e0
+    {MN_POP,  {O_PAIR_H,   O_NONE},  FLOW_NEXT},    // e1
+    {MN_JPO,  {O_ADDR,     O_NONE},  FLOW_CJUMP},   // e2
+    {MN_XTHL, {O_NONE,     O_NONE},  FLOW_NEXT},    // e3
+    {MN_CPO,  {O_ADDR,     O_NONE},  FLOW_CCALL},   // e4
+    {MN_PUSH, {O_PAIR_H,   O_NONE},  FLOW_NEXT},    // e5
+    {MN_ANI,  {O_IMM8,     O_NONE},  FLOW_NEXT},    // e6
+    {MN_RST,  {O_RST(4),   O_NONE},  FLOW_CALL},    // e7
+    {MN_RPE,  {O_NONE,     O_NONE},  FLOW_CRET},    // e8
+    {MN_PCHL, {O_NONE,     O_NONE},  FLOW_INDIRECT},// e9
+    {MN_JPE,  {O_ADDR,     O_NONE},  FLOW_CJUMP},   // ea
+    {MN_XCHG, {O_NONE,     O_NONE},  FLOW_NEXT},    // eb
+    {MN_CPE,  {O_ADDR,     O_NONE},  FLOW_CCALL},   // ec
+    {MN_CALL, {O_ADDR,     O_NONE},  FLOW_CALL},    // ed
+    {MN_XRI,  {O_IMM8,     O_NONE},  FLOW_NEXT},    // ee
+    {MN_RST,  {O_RST(5),   O_NONE},  FLOW_CALL},    // ef
+    {MN_RP,   {O_NONE,     O_NONE},  FLOW_CRET},    // f0
+    {MN_POP,  {O_PAIR_PSW, O_NONE},  FLOW_NEXT},    // f1
+    {MN_JP,   {O_ADDR,     O_NONE},  FLOW_CJUMP},   // f2
+    {MN_DI,   {O_NONE,     O_NONE},  FLOW_NEXT},    // f3
+    {MN_CP,   {O_ADDR,     O_NONE},  FLOW_CCALL},   // f4
+    {MN_PUSH, {O_PAIR_PSW, O_NONE},  FLOW_NEXT},    // f5
+    {MN_ORI,  {O_IMM8,     O_NONE},  FLOW_NEXT},    // f6
+    {MN_RST,  {O_RST(6),   O_NONE},  FLOW_CALL},    // f7
+    {MN_RM,   {O_NONE,     O_NONE},  FLOW_CRET},    // f8
+    {MN_SPHL, {O_NONE,     O_NONE},  FLOW_NEXT},    // f9
+    {MN_JM,   {O_ADDR,     O_NONE},  FLOW_CJUMP},   // fa
+    {MN_EI,   {O_NONE,     O_NONE},  FLOW_NEXT},    // fb
+    {MN_CM,   {O_ADDR,     O_NONE},  FLOW_CCALL},   // fc
+    {MN_CALL, {O_ADDR,     O_NONE},  FLOW_CALL},    // fd
+    {MN_CPI,  {O_IMM8,     O_NONE},  FLOW_NEXT},    // fe
+    {MN_RST,  {O_RST(7),   O_NONE},  FLOW_CALL},    // ff
+};
+
+#define MNEMONIC_NAME(name) #name,
+static const char *const mnemonic_names[MN_COUNT] = { MNEMONICS(MNEMONIC_NAME) };
+#undef MNEMONIC_NAME
+
+static const char *const reg_names[8] = {"B", "C", "D", "E", "H", "L", "M", "A"};
+static const char *const pair_names[5] = {"B", "D", "H", "SP", "PSW"};
+
+const char *Mnemonic8080(int mnemonic) {
+    return mnemonic_names[mnemonic];
+}
+
+// Fills `ins` from the bytes at `code`; `pc` is the address of code[0].
+// Returns the instruction length.
+int Decode8080(const uint8_t *code, uint16_t pc, Instr8080 *ins) {
+    const OpInfo *info = &ops[code[0]];
+
+    ins->pc = pc;
+    ins->opcode = code[0];
+    ins->mnemonic = info->mnemonic;
+    ins->length = length8080[code[0]];
+    ins->flow = info->flow;
+    ins->cycles = cycles8080[code[0]];
+    ins->cycles_taken = ins->cycles + ((info->flow == FLOW_CCALL || info->flow == FLOW_CRET) ? 6 : 0);
+    for (int i = 0; i < 2; i++) {
+        Operand8080 *o = &ins->operand[i];
+        o->kind = info->operand[i] >> 4;
+        switch (o->kind) {
+            case OPND_IMM8:
+            case OPND_PORT:
+                o->value = code[1];
+                break;
+            case OPND_IMM16:
+            case OPND_ADDR:
+                o->value = code[1] | code[2] << 8;
+                break;
+            default:
+                o->value = info->operand[i] & 0xf;
+                break;
+        }
+    }
+    return ins->length;
+}
+
+// Branch target of a jump, call or RST
+uint16_t Target8080(const Instr8080 *ins) {
+    if (ins->operand[0].kind == OPND_RST)
+        return ins->operand[0].value * 8;
+    return ins->operand[0].value;
+}
+
+static const char hexdigits[] = "0123456789abcdef";
+
+// The formatters build text with these instead of printf; the listing
+// of a whole ROM is dominated by formatting otherwise.
+static char *PutString(char *out, const char *s)
+{
+    while (*s)
+        *out++ = *s++;
+    return out;
+}
+
+static char *PutHex(char *out, unsigned v, int digits)
+{
+    for (int i = digits - 1; i >= 0; i--)
+        *out++ = hexdigits[(v >> (4 * i)) & 0xf];
+    return out;
+}
+
+// Copies len bytes to buf[*n] as far as they fit and keeps counting
+static void Append(char *buf, size_t size, size_t *n, const char *text, size_t len)
+{
+    if (*n < size) {
+        size_t room = size - *n - 1;
+        size_t copy = len < room ? len : room;
+        memcpy(buf + *n, text, copy);
+        buf[*n + copy] = '\0';
+    }
+    *n += len;
+}
+
+static char *PutOperand(char *out, const Instr8080 *ins, const Operand8080 *o, const uint8_t *labels)
+{
+    switch (o->kind) {
+        case OPND_REG:
+            return PutString(out, reg_names[o->value]);
+        case OPND_PAIR:
+            return PutString(out, pair_names[o->value]);
+        case OPND_IMM8:
+        case OPND_PORT:
+            return PutHex(PutString(out, "#$"), o->value, 2);
+        case OPND_IMM16:
+            return PutHex(PutString(out, "#$"), o->value, 4);
+        case OPND_ADDR:
+            if (labels && ins->flow != FLOW_NEXT && (labels[o->value] & LIST_LABEL))
+                return PutHex(PutString(out, "L"), o->value, 4);
+            return PutHex(PutString(out, "$"), o->value, 4);
+        case OPND_RST:
+            *out++ = '0' + o->value;
+            return out;
+        default:
+            return out;
+    }
+}
+
+static char *PutInstr(char *out, const Instr8080 *ins, const uint8_t *labels)
+{
+    const char *name = mnemonic_names[ins->mnemonic];
+    char *start = out;
+    out = PutString(out, name);
+    if (ins->operand[0].kind == OPND_NONE)
+        return out;
+    while (out - start < 7)
+        *out++ = ' ';
+    out = PutOperand(out, ins, &ins->operand[0], labels);
+    if (ins->operand[1].kind != OPND_NONE) {
+        *out++ = ',';
+        out = PutOperand(out, ins, &ins->operand[1], labels);
+    }
+    return out;
+}
+
+// Writes the assembler text of `ins` into buf, snprintf style. When
+// `labels` (Listing flags) is given, branch targets print as labels.
+int Format8080(const Instr8080 *ins, char *buf, size_t size, const uint8_t *labels) {
+    char text[32];
+    size_t n = 0;
+    Append(buf, size, &n, text, PutInstr(text, ins, labels) - text);
+    return (int) n;
+}
+
+int Disassemble8080Op(unsigned char *codebuffer, int pc) {
+    Instr8080 ins;
+    char text[32];
+    Decode8080(&codebuffer[pc], pc, &ins);
+    Format8080(&ins, text, sizeof(text), NULL);
+    printf("%04x %s\n", pc, text);
+    return ins.length;
+}
+
+void ListingInit(Listing *listing, uint16_t start, uint32_t end) {
+    memset(listing->flags, 0, sizeof(listing->flags));
+    listing->start = start;
+    listing->end = end;
+}
+
+static int InRange(const Listing *listing, uint32_t addr)
+{
+    return addr >= listing->start && addr < listing->end;
+}
+
+// Follows every path of execution from `entry` that stays in range
+void ListingTrace(Listing *listing, const uint8_t *memory, uint16_t entry) {
+    static uint16_t work[0x10000];
+    int top = 0;
+    Instr8080 ins;
+
+    work[top++] = entry;
+    if (InRange(listing, entry))
+        listing->flags[entry] |= LIST_LABEL;
+    while (top > 0) {
+        uint32_t pc = work[--top];
+        while (InRange(listing, pc) && !(listing->flags[pc] & (LIST_CODE | LIST_BODY))) {
+            Decode8080(&memory[pc], pc, &ins);
+            if (pc + ins.length > listing->end)
+                break;
+            listing->flags[pc] |= LIST_CODE;
+            for (int i = 1; i < ins.length; i++)
+                listing->flags[pc + i] |= LIST_BODY;
+
+            if (ins.flow == FLOW_JUMP || ins.flow == FLOW_CJUMP ||
+                ins.flow == FLOW_CALL || ins.flow == FLOW_CCALL) {
+                uint16_t target = Target8080(&ins);
+                if (InRange(listing, target)) {
+                    listing->flags[target] |= LIST_LABEL;
+                    if (!(listing->flags[target] & LIST_CODE) && top < 0x10000)
+                        work[top++] = target;
+                }
+            }
+            if (ins.flow == FLOW_JUMP || ins.flow == FLOW_RET ||
+                ins.flow == FLOW_INDIRECT || ins.flow == FLOW_HALT)
+                break;
+            pc += ins.length;
+        }
+    }
+}
+
+// Treats every byte not yet reached as straight-line code
+void ListingSweep(Listing *listing, const uint8_t *memory) {
+    Instr8080 ins;
+    uint32_t pc = listing->start;
+    while (pc < listing->end) {
+        if (listing->flags[pc] & (LIST_CODE | LIST_BODY)) {
+            pc++;
+            continue;
+        }
+        Decode8080(&memory[pc], pc, &ins);
+        if (pc + ins.length > listing->end)
+            break;
+        listing->flags[pc] |= LIST_CODE;
+        for (int i = 1; i < ins.length; i++)
+            listing->flags[pc + i] |= LIST_BODY;
+        if (ins.flow != FLOW_NEXT && ins.operand[0].kind == OPND_ADDR && InRange(listing, ins.operand[0].value))
+            listing->flags[ins.operand[0].value] |= LIST_LABEL;
+        pc += ins.length;
+    }
+}
+
+// Writes the listing into buf, snprintf style: the return value is the
+// full length, which may exceed size.
+size_t ListingFormat(const Listing *listing, const uint8_t *memory, char *buf, size_t size) {
+    size_t n = 0;
+    char line[64];
+    Instr8080 ins;
+
+    for (uint32_t pc = listing->start; pc < listing->end; pc++) {
+        uint8_t flags = listing->flags[pc];
+        char *out = line;
+        if (flags & LIST_BODY)
+            continue;
+        if (flags & LIST_LABEL) {
+            out = PutHex(PutString(out, "L"), pc, 4);
+            out = PutString(out, ":\n");
+        }
+        out = PutHex(out, pc, 4);
+        out = PutString(out, "  ");
+        if (flags & LIST_CODE) {
+            Decode8080(&memory[pc], pc, &ins);
+            for (int i = 0; i < 3; i++) {
+                if (i < ins.length)
+                    out = PutHex(out, memory[pc + i], 2);
+                else
+                    out = PutString(out, "  ");
+                *out++ = ' ';
+            }
+            out = PutInstr(PutString(out, "   "), &ins, listing->flags);
+        } else {
+            out = PutHex(out, memory[pc], 2);
+            out = PutHex(PutString(out, "          DB     $"), memory[pc], 2);
+        }
+        *out++ = '\n';
+        Append(buf, size, &n, line, out - line);
+    }
+    return n;
+}
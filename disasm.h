@@ -0,0 +1,85 @@
+#ifndef DISASM_H
+#define DISASM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define MNEMONICS(X) \
+    X(NOP) X(LXI) X(STAX) X(INX) X(INR) X(DCR) X(MVI) X(RLC) X(DAD) X(LDAX) \
+    X(DCX) X(RRC) X(RAL) X(RAR) X(SHLD) X(DAA) X(LHLD) X(CMA) X(STA) X(STC) \
+    X(LDA) X(CMC) X(MOV) X(HLT) X(ADD) X(ADC) X(SUB) X(SBB) X(ANA) X(XRA) \
+    X(ORA) X(CMP) X(RNZ) X(POP) X(JNZ) X(JMP) X(CNZ) X(PUSH) X(ADI) X(RST) \
+    X(RZ) X(RET) X(JZ) X(CZ) X(CALL) X(ACI) X(RNC) X(JNC) X(OUT) X(CNC) \
+    X(SUI) X(RC) X(JC) X(IN) X(CC) X(SBI) X(RPO) X(JPO) X(XTHL) X(CPO) \
+    X(ANI) X(RPE) X(PCHL) X(JPE) X(XCHG) X(CPE) X(XRI) X(RP) X(JP) X(DI) \
+    X(CP) X(ORI) X(RM) X(SPHL) X(JM) X(EI) X(CM) X(CPI)
+
+#define MNEMONIC_ENUM(name) MN_##name,
+enum { MNEMONICS(MNEMONIC_ENUM) MN_COUNT };
+#undef MNEMONIC_ENUM
+
+enum {
+    OPND_NONE,
+    OPND_REG,       // value 0-7: B C D E H L M A
+    OPND_PAIR,      // value 0-4: B D H SP PSW
+    OPND_IMM8,
+    OPND_IMM16,
+    OPND_ADDR,      // memory or branch address
+    OPND_PORT,
+    OPND_RST,       // value 0-7
+};
+
+// How an instruction affects the flow of control
+enum {
+    FLOW_NEXT,
+    FLOW_JUMP,
+    FLOW_CJUMP,
+    FLOW_CALL,      // also RST
+    FLOW_CCALL,
+    FLOW_RET,
+    FLOW_CRET,
+    FLOW_INDIRECT,  // PCHL
+    FLOW_HALT,
+};
+
+typedef struct Operand8080 {
+    uint8_t kind;
+    uint16_t value;
+} Operand8080;
+
+typedef struct Instr8080 {
+    uint16_t pc;
+    uint8_t opcode;
+    uint8_t mnemonic;
+    uint8_t length;
+    uint8_t cycles;         // conditional calls and returns when not taken
+    uint8_t cycles_taken;
+    uint8_t flow;
+    Operand8080 operand[2];
+} Instr8080;
+
+int Decode8080(const uint8_t *code, uint16_t pc, Instr8080 *ins);
+const char *Mnemonic8080(int mnemonic);
+uint16_t Target8080(const Instr8080 *ins);
+int Format8080(const Instr8080 *ins, char *buf, size_t size, const uint8_t *labels);
+int Disassemble8080Op(unsigned char *codebuffer, int pc);
+
+// Whole-program disassembly. Recursive descent from the entry points
+// marks instruction starts and branch targets; bytes never reached are
+// listed as data unless a linear sweep is requested.
+#define LIST_CODE   0x01    // first byte of an instruction
+#define LIST_BODY   0x02    // operand byte of an instruction
+#define LIST_LABEL  0x04    // target of a jump, call or RST
+
+typedef struct Listing {
+    uint8_t flags[0x10000];
+    uint16_t start;
+    uint32_t end;           // exclusive
+} Listing;
+
+void ListingInit(Listing *listing, uint16_t start, uint32_t end);
+void ListingTrace(Listing *listing, const uint8_t *memory, uint16_t entry);
+void ListingSweep(Listing *listing, const uint8_t *memory);
+size_t ListingFormat(const Listing *listing, const uint8_t *memory, char *buf, size_t size);
+
+#endif
@@ -0,0 +1,283 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "env.h"
+#include "idle.h"
+#include "pacing.h"
+
+// splitmix64, to turn the reset seed into one generator per env
+static uint64_t Mix(uint64_t x)
+{
+    x += 0x9e3779b97f4a7c15ull;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+}
+
+// xorshift64
+static uint64_t Random(Env *env)
+{
+    env->rng ^= env->rng << 13;
+    env->rng ^= env->rng >> 7;
+    env->rng ^= env->rng << 17;
+    return env->rng;
+}
+
+static uint32_t Score(const Machine *machine, const State8080 *state)
+{
+    const GameRam *game = &machine->game;
+    uint32_t score = 0;
+    for (int i = game->score_bytes - 1; i >= 0; i--) {
+        uint8_t bcd = MemRead(state, game->score + i);
+        score = score * 100 + (bcd >> 4) * 10 + (bcd & 0xf);
+    }
+    return score;
+}
+
+static uint8_t Playing(const Machine *machine, const State8080 *state)
+{
+    return machine->game.playing && MemRead(state, machine->game.playing) != 0;
+}
+
+// MachineRunFrame, counted for the env and its worker
+static int RunFrame(Env *env)
+{
+    uint64_t start = PacerNow();
+    if (!MachineRunFrame(env->state, env->cache, &env->sched, &env->video))
+        return 0;
+    env->frames++;
+    CountersFrame(env->state->counters, PacerNow() - start);
+    return 1;
+}
+
+static const uint8_t *Vram(const EnvBatch *batch, const Env *env)
+{
+    return &env->state->memory[batch->machine->video.base];
+}
+
+// Power on from the loaded ROMs, then idle for a random number of frames
+static void ResetEnv(EnvBatch *batch, int i)
+{
+    Env *env = &batch->env[i];
+    State8080 *state = env->state;
+    const Machine *machine = batch->machine;
+
+    memcpy(state->memory, batch->image, MEMORY_ALLOC);
+    memset(state->map->dirty, DIRTY_ALL, sizeof(state->map->dirty));
+    state->cycles = 0;
+    state->pc = 0;
+    state->sp = 0;
+    state->psw = 0;
+    state->bc = state->de = state->hl = 0;
+    state->int_enable = 0;
+    state->halted = 0;
+    state->port.shift = 0;
+    state->port.shift_amount = 0;
+    memcpy(state->port.in, machine->in_default, sizeof(state->port.in));
+    memset(state->idle, 0, sizeof(*state->idle));
+    SchedulerInit(&env->sched);
+    VideoInit(&env->video, machine, state, &env->sched);
+
+    int noops = Random(env) % (ENV_MAX_NOOPS + 1);
+    for (int f = 0; f < noops && RunFrame(env); f++)
+        ;
+    env->score = Score(machine, state);
+    env->playing = Playing(machine, state);
+    env->episodes++;
+    ObsStackFill(env->obs, Vram(batch, env));
+    ObsStackWrite(env->obs, batch->obs + i * batch->obs_bytes);
+}
+
+static void StepEnv(EnvBatch *batch, int i)
+{
+    Env *env = &batch->env[i];
+    State8080 *state = env->state;
+    const Machine *machine = batch->machine;
+    int32_t reward = 0;
+    int done = 0;
+
+    state->port.in[ENV_PLAYER_PORT] = machine->in_default[ENV_PLAYER_PORT] | batch->actions[i];
+    for (int f = 0; f < batch->frames_per_step && !done; f++) {
+        if (!RunFrame(env)) {
+            done = 1;
+            break;
+        }
+        // A new game clears the score, which is no loss
+        uint32_t score = Score(machine, state);
+        if (score > env->score)
+            reward += score - env->score;
+        env->score = score;
+
+        uint8_t playing = Playing(machine, state);
+        if (env->playing && !playing)
+            done = 1;
+        env->playing = playing;
+    }
+
+    batch->reward[i] = reward;
+    batch->done[i] = done;
+    if (done) {
+        ResetEnv(batch, i);
+    } else {
+        ObsStackPush(env->obs, Vram(batch, env));
+        ObsStackWrite(env->obs, batch->obs + i * batch->obs_bytes);
+    }
+}
+
+static void RunPart(EnvBatch *batch, int part)
+{
+    int first = (int64_t) batch->n * part / batch->threads;
+    int last = (int64_t) batch->n * (part + 1) / batch->threads;
+    for (int i = first; i < last; i++) {
+        if (batch->job == ENV_JOB_RESET) {
+            batch->env[i].rng = Mix(batch->seed + i) | 1;
+            ResetEnv(batch, i);
+        } else {
+            StepEnv(batch, i);
+        }
+    }
+}
+
+static void *Worker(void *arg)
+{
+    EnvWorker *worker = arg;
+    EnvBatch *batch = worker->batch;
+    uint64_t seen = 0;
+
+    pthread_mutex_lock(&batch->lock);
+    for (;;) {
+        while (batch->generation == seen && !batch->quit)
+            pthread_cond_wait(&batch->start, &batch->lock);
+        if (batch->quit)
+            break;
+        seen = batch->generation;
+        pthread_mutex_unlock(&batch->lock);
+
+        RunPart(batch, worker->part);
+
+        pthread_mutex_lock(&batch->lock);
+        if (--batch->pending == 0)
+            pthread_cond_signal(&batch->finished);
+    }
+    pthread_mutex_unlock(&batch->lock);
+    return NULL;
+}
+
+// Hands the job in `batch` to the workers, runs part 0 and waits for the
+// rest
+static void RunJob(EnvBatch *batch)
+{
+    pthread_mutex_lock(&batch->lock);
+    batch->pending = batch->threads - 1;
+    batch->generation++;
+    pthread_cond_broadcast(&batch->start);
+    pthread_mutex_unlock(&batch->lock);
+
+    RunPart(batch, 0);
+
+    pthread_mutex_lock(&batch->lock);
+    while (batch->pending)
+        pthread_cond_wait(&batch->finished, &batch->lock);
+    pthread_mutex_unlock(&batch->lock);
+}
+
+// Every env loads the ROMs from the working directory. `threads` is
+// clamped to the number of envs; the caller's thread is one of them. A
+// NULL `obs` is the packed frame buffer.
+EnvBatch *EnvCreate(const Machine *machine, int envs, int threads, int frames_per_step,
+                    const ObsFormat *obs) {
+    static const ObsFormat packed = {0};
+    if (envs < 1) {
+        printf("error: need at least one environment\n");
+        exit(1);
+    }
+    EnvBatch *batch = calloc(1, sizeof(EnvBatch));
+    batch->machine = machine;
+    batch->n = envs;
+    batch->frames_per_step = frames_per_step > 0 ? frames_per_step : 1;
+    batch->env = aligned_alloc(CACHE_LINE, envs * sizeof(Env));
+    memset(batch->env, 0, envs * sizeof(Env));
+    for (int i = 0; i < envs; i++) {
+        Env *env = &batch->env[i];
+        env->state = Init8080();
+        env->state->idle = IdleCreate();
+        env->cache = DecodeCacheCreate();
+        env->obs = ObsStackCreate(obs ? obs : &packed, &machine->video);
+        MachineLoad(machine, env->state);
+    }
+    batch->obs_bytes = batch->env[0].obs->frame_bytes * batch->env[0].obs->format.stack;
+    batch->image = malloc(MEMORY_ALLOC);
+    memcpy(batch->image, batch->env[0].state->memory, MEMORY_ALLOC);
+
+    batch->threads = threads < 1 ? 1 : threads > envs ? envs : threads;
+    batch->worker = calloc(batch->threads, sizeof(EnvWorker));
+    for (int t = 0; t < batch->threads; t++) {
+        char name[32];
+        snprintf(name, sizeof(name), "env%d", t);
+        batch->worker[t].counters = CountersCreate(name);
+        for (int i = (int64_t) envs * t / batch->threads; i < (int64_t) envs * (t + 1) / batch->threads; i++)
+            batch->env[i].state->counters = batch->worker[t].counters;
+    }
+    pthread_mutex_init(&batch->lock, NULL);
+    pthread_cond_init(&batch->start, NULL);
+    pthread_cond_init(&batch->finished, NULL);
+    for (int t = 1; t < batch->threads; t++) {
+        batch->worker[t].batch = batch;
+        batch->worker[t].part = t;
+        if (pthread_create(&batch->worker[t].thread, NULL, Worker, &batch->worker[t]) != 0) {
+            printf("error: Couldn't start environment thread %d\n", t);
+            exit(1);
+        }
+    }
+    return batch;
+}
+
+size_t EnvObsBytes(const EnvBatch *batch) {
+    return batch->obs_bytes;
+}
+
+// Resets every env; env i draws its no-op count from seed + i. `obs`
+// receives n observations.
+void EnvReset(EnvBatch *batch, uint64_t seed, uint8_t *obs) {
+    batch->job = ENV_JOB_RESET;
+    batch->seed = seed;
+    batch->obs = obs;
+    RunJob(batch);
+}
+
+// Holds actions[i] on env i for frames_per_step frames, or until its
+// episode ends
+void EnvStep(EnvBatch *batch, const uint8_t *actions, uint8_t *obs, int32_t *reward, uint8_t *done) {
+    batch->job = ENV_JOB_STEP;
+    batch->actions = actions;
+    batch->obs = obs;
+    batch->reward = reward;
+    batch->done = done;
+    RunJob(batch);
+}
+
+void EnvFree(EnvBatch *batch) {
+    pthread_mutex_lock(&batch->lock);
+    batch->quit = 1;
+    pthread_cond_broadcast(&batch->start);
+    pthread_mutex_unlock(&batch->lock);
+    for (int t = 1; t < batch->threads; t++)
+        pthread_join(batch->worker[t].thread, NULL);
+    pthread_mutex_destroy(&batch->lock);
+    pthread_cond_destroy(&batch->start);
+    pthread_cond_destroy(&batch->finished);
+
+    for (int i = 0; i < batch->n; i++) {
+        State8080 *state = batch->env[i].state;
+        free(batch->env[i].cache);
+        ObsStackFree(batch->env[i].obs);
+        free(state->idle);
+        free(state->memory);
+        free(state->map);
+        free(state);
+    }
+    free(batch->env);
+    free(batch->image);
+    free(batch->worker);
+    free(batch);
+}
@@ -0,0 +1,105 @@
+#ifndef ENV_H
+#define ENV_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <pthread.h>
+#include "cpu8080.h"
+#include "scheduler.h"
+#include "fused.h"
+#include "machine.h"
+#include "obs.h"
+#include "counters.h"
+
+// Reinforcement-learning environments: a batch of independent machines
+// stepped together, in the style of a vectorized Gym environment.
+//
+//   EnvBatch *batch = EnvCreate(MachineFind("invaders"), 16, 4, 4, NULL);
+//   EnvReset(batch, seed, obs);
+//   for (;;)
+//       EnvStep(batch, actions, obs, reward, done);
+//
+// An action is the player 1 input port (port 1 on every board here) as a
+// mask of ENV_ bits, held for the whole step. Observations are exported
+// in the batch's ObsFormat (the packed frame buffer by default) and stacked
+// over steps, EnvObsBytes apart in the caller's buffer. The reward is
+// the growth of the score in RAM and an episode ends when the game in
+// progress is over; boards whose GameRam is unknown give neither. An
+// environment that is done is reset within the same step, so the
+// observation returned with done set is the first of the next episode.
+
+#define ENV_COIN    0x01
+#define ENV_START1  0x04
+#define ENV_FIRE    0x10
+#define ENV_LEFT    0x20
+#define ENV_RIGHT   0x40
+
+#define ENV_PLAYER_PORT 1
+
+// A reset runs up to this many frames with no input, picked from the
+// seed, so episodes do not all start in lockstep
+#define ENV_MAX_NOOPS 30
+
+typedef struct Env {
+    _Alignas(CACHE_LINE) State8080 *state;
+    Scheduler sched;
+    Video video;
+    DecodeCache *cache;
+    ObsStack *obs;
+    uint64_t rng;
+    uint32_t score;
+    uint8_t playing;
+    uint64_t frames;
+    uint64_t episodes;
+} Env;
+
+typedef enum EnvJob {
+    ENV_JOB_RESET,
+    ENV_JOB_STEP,
+} EnvJob;
+
+struct EnvBatch;
+
+// Worker `part` steps its contiguous share of the envs; the caller's
+// thread runs part 0 itself. Each part counts into its own set.
+typedef struct EnvWorker {
+    struct EnvBatch *batch;
+    int part;
+    pthread_t thread;
+    Counters *counters;
+} EnvWorker;
+
+typedef struct EnvBatch {
+    const Machine *machine;
+    Env *env;
+    int n;
+    int frames_per_step;
+    uint8_t *image;         // memory right after MachineLoad
+    size_t obs_bytes;
+
+    // The job the workers run, over the envs they own
+    EnvJob job;
+    uint64_t seed;
+    const uint8_t *actions;
+    uint8_t *obs;
+    int32_t *reward;
+    uint8_t *done;
+
+    int threads;
+    EnvWorker *worker;
+    pthread_mutex_t lock;
+    pthread_cond_t start;
+    pthread_cond_t finished;
+    uint64_t generation;
+    int pending;
+    int quit;
+} EnvBatch;
+
+EnvBatch *EnvCreate(const Machine *machine, int envs, int threads, int frames_per_step,
+                    const ObsFormat *obs);
+size_t EnvObsBytes(const EnvBatch *batch);
+void EnvReset(EnvBatch *batch, uint64_t seed, uint8_t *obs);
+void EnvStep(EnvBatch *batch, const uint8_t *actions, uint8_t *obs, int32_t *reward, uint8_t *done);
+void EnvFree(EnvBatch *batch);
+
+#endif
@@ -0,0 +1,129 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "env.h"
+#include "pacing.h"
+#include "metrics.h"
+
+// Steps a batch of RL environments with a random policy and reports the
+// throughput. The digest covers every observation, reward and done flag,
+// so it must not change with the number of threads.
+//
+//   envbench [-machine name] [-envs N] [-threads N] [-frames-per-step N]
+//            [-steps N] [-seed N] [-obs format] [-stack N]
+//
+// with formats as in obs.h.
+
+static const uint8_t policy[] = {
+    0, ENV_FIRE, ENV_LEFT, ENV_RIGHT, ENV_LEFT | ENV_FIRE, ENV_RIGHT | ENV_FIRE,
+};
+
+static uint64_t Random(uint64_t *rng)
+{
+    *rng ^= *rng << 13;
+    *rng ^= *rng >> 7;
+    *rng ^= *rng << 17;
+    return *rng;
+}
+
+// FNV-1a
+static uint64_t Digest(uint64_t h, const void *data, size_t size)
+{
+    const uint8_t *p = data;
+    for (size_t i = 0; i < size; i++) {
+        h ^= p[i];
+        h *= 0x100000001b3ull;
+    }
+    return h;
+}
+
+static void Usage(const char *prog)
+{
+    printf("usage: %s [-machine name] [-envs N] [-threads N] [-frames-per-step N]\n"
+           "          [-steps N] [-seed N] [-obs packed|rotated|[rotated-]gray:WxH] [-stack N]\n"
+           "          [-metrics [host]:port|socket-path|-]\n",
+           prog);
+    exit(1);
+}
+
+int main(int argc, char **argv) {
+    const Machine *machine = &machines[0];
+    int envs = 8;
+    int threads = sysconf(_SC_NPROCESSORS_ONLN);
+    int frames_per_step = 4;
+    int steps = 2000;
+    uint64_t seed = 1;
+    ObsFormat format = {0};
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-machine") == 0 && i + 1 < argc)
+            machine = MachineFind(argv[++i]);
+        else if (strcmp(argv[i], "-envs") == 0 && i + 1 < argc)
+            envs = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-threads") == 0 && i + 1 < argc)
+            threads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-frames-per-step") == 0 && i + 1 < argc)
+            frames_per_step = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-steps") == 0 && i + 1 < argc)
+            steps = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-seed") == 0 && i + 1 < argc)
+            seed = strtoull(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "-obs") == 0 && i + 1 < argc) {
+            if (ObsParse(argv[++i], &format) != 0)
+                Usage(argv[0]);
+        } else if (strcmp(argv[i], "-stack") == 0 && i + 1 < argc)
+            format.stack = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-metrics") == 0 && i + 1 < argc)
+            MetricsServe(argv[++i]);
+        else
+            Usage(argv[0]);
+    }
+
+    EnvBatch *batch = EnvCreate(machine, envs, threads, frames_per_step, &format);
+    uint8_t *obs = malloc(envs * EnvObsBytes(batch));
+    uint8_t *actions = calloc(envs, 1);
+    int32_t *reward = calloc(envs, sizeof(int32_t));
+    uint8_t *done = calloc(envs, 1);
+    uint64_t rng = seed | 1;
+    uint64_t digest = 0xcbf29ce484222325ull;
+    int64_t total_reward = 0;
+    uint64_t episodes = 0;
+
+    uint64_t t0 = PacerNow();
+    EnvReset(batch, seed, obs);
+    for (int s = 0; s < steps; s++) {
+        // Now and then drop a coin and press start, so games get played
+        for (int i = 0; i < envs; i++) {
+            uint64_t r = Random(&rng);
+            actions[i] = r % 64 == 0 ? ENV_COIN | ENV_START1 : policy[(r >> 8) % sizeof(policy)];
+        }
+        EnvStep(batch, actions, obs, reward, done);
+        for (int i = 0; i < envs; i++) {
+            total_reward += reward[i];
+            episodes += done[i];
+        }
+        digest = Digest(digest, obs, envs * EnvObsBytes(batch));
+        digest = Digest(digest, reward, envs * sizeof(int32_t));
+        digest = Digest(digest, done, envs);
+    }
+    double seconds = (PacerNow() - t0) / 1e9;
+
+    uint64_t frames = 0;
+    for (int i = 0; i < envs; i++)
+        frames += batch->env[i].frames;
+    printf("%s: %d envs on %d threads, %d frames per step, %zu byte observations\n",
+           machine->name, envs, batch->threads, batch->frames_per_step, EnvObsBytes(batch));
+    printf("%.0f env steps/s, %.0f frames/s (%.0fx realtime) over %.2f s\n",
+           (double) steps * envs / seconds, frames / seconds,
+           frames / seconds / FRAMES_PER_SECOND, seconds);
+    printf("%llu episodes ended, reward %lld, digest %016llx\n",
+           (unsigned long long) episodes, (long long) total_reward, (unsigned long long) digest);
+
+    EnvFree(batch);
+    free(obs);
+    free(actions);
+    free(reward);
+    free(done);
+    return 0;
+}
@@ -0,0 +1,61 @@
+#include <stdlib.h>
+#include <string.h>
+#include "frameskip.h"
+
+// Upper bound on consecutive skips in adaptive mode so the screen keeps
+// updating a few times per second even on a badly overloaded host.
+#define ADAPTIVE_DEFAULT_MAX 9
+
+void FrameSkipInit(FrameSkip *fs, SkipMode mode, int skip) {
+    memset(fs, 0, sizeof(*fs));
+    fs->mode = mode;
+    fs->skip = skip;
+}
+
+// Accepts a fixed count such as "3", or "auto" / "auto:N" for adaptive
+int FrameSkipParse(const char *arg, SkipMode *mode, int *skip) {
+    char *end;
+    if (strncmp(arg, "auto", 4) == 0) {
+        *mode = SKIP_ADAPTIVE;
+        *skip = ADAPTIVE_DEFAULT_MAX;
+        if (arg[4] == '\0')
+            return 0;
+        if (arg[4] != ':')
+            return -1;
+        arg += 5;
+    } else {
+        *mode = SKIP_FIXED;
+    }
+    long n = strtol(arg, &end, 10);
+    if (end == arg || *end != '\0' || n < 0)
+        return -1;
+    *skip = (int) n;
+    if (*skip == 0)
+        *mode = SKIP_NONE;
+    return 0;
+}
+
+// Decides whether the frame that just finished should be decoded and
+// presented. A skipped frame costs nothing beyond the CPU emulation.
+int FrameSkipShouldDraw(FrameSkip *fs, const Pacer *pacer) {
+    int draw;
+    switch (fs->mode) {
+        case SKIP_FIXED:
+            draw = (fs->run >= fs->skip);
+            break;
+        case SKIP_ADAPTIVE:
+            draw = (fs->run >= fs->skip) || !PacerBehind(pacer);
+            break;
+        default:
+            draw = 1;
+            break;
+    }
+    if (draw) {
+        fs->run = 0;
+        fs->drawn++;
+    } else {
+        fs->run++;
+        fs->skipped++;
+    }
+    return draw;
+}
@@ -0,0 +1,25 @@
+#ifndef FRAMESKIP_H
+#define FRAMESKIP_H
+
+#include <stdint.h>
+#include "pacing.h"
+
+typedef enum SkipMode {
+    SKIP_NONE,          // draw every frame
+    SKIP_FIXED,         // draw one frame, then skip `skip` frames
+    SKIP_ADAPTIVE,      // skip only while the pacer is behind, at most `skip` in a row
+} SkipMode;
+
+typedef struct FrameSkip {
+    SkipMode mode;
+    int skip;
+    int run;            // frames skipped since the last drawn frame
+    uint64_t drawn;
+    uint64_t skipped;
+} FrameSkip;
+
+void FrameSkipInit(FrameSkip *fs, SkipMode mode, int skip);
+int FrameSkipParse(const char *arg, SkipMode *mode, int *skip);
+int FrameSkipShouldDraw(FrameSkip *fs, const Pacer *pacer);
+
+#endif
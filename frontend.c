@@ -0,0 +1,207 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include "frontend.h"
+#include "profile.h"
+#include "idle.h"
+#include "metrics.h"
+
+static void Usage(const char *prog, const char *help)
+{
+    printf("usage: %s [-speed max|realtime|<N>x] [-frameskip N|auto[:N]] [-stats]\n"
+           "          [-capture prefix] [-frames N] [-journal file] [-nofuse] [-noidle]\n"
+           "          [-gdb [host]:port|socket-path] [-trace file] [-machine name]\n"
+           "          [-dip name=value]... [-runahead N] [-metrics [host]:port|socket-path|-]\n"
+           "%s", prog, help ? help : "");
+    exit(1);
+}
+
+// `pace_mode` is the frontend's default speed; `help` goes under the usage
+void FrontendParse(Frontend *fe, int argc, char **argv, PaceMode pace_mode, const char *help) {
+    memset(fe, 0, sizeof(Frontend));
+    fe->pace_mode = pace_mode;
+    fe->pace_multiplier = 1.0;
+    fe->skip_mode = SKIP_NONE;
+    fe->fuse = 1;
+    fe->idle_skip = 1;
+    fe->machine = &machines[0];
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-speed") == 0 && i + 1 < argc) {
+            if (PacerParseMode(argv[++i], &fe->pace_mode, &fe->pace_multiplier) != 0)
+                Usage(argv[0], help);
+        } else if (strcmp(argv[i], "-frameskip") == 0 && i + 1 < argc) {
+            if (FrameSkipParse(argv[++i], &fe->skip_mode, &fe->skip) != 0)
+                Usage(argv[0], help);
+        } else if (strcmp(argv[i], "-stats") == 0) {
+            fe->show_stats = 1;
+        } else if (strcmp(argv[i], "-nofuse") == 0) {
+            fe->fuse = 0;
+        } else if (strcmp(argv[i], "-noidle") == 0) {
+            fe->idle_skip = 0;
+        } else if (strcmp(argv[i], "-gdb") == 0 && i + 1 < argc) {
+            fe->debug_address = argv[++i];
+        } else if (strcmp(argv[i], "-trace") == 0 && i + 1 < argc) {
+            fe->trace_path = argv[++i];
+        } else if (strcmp(argv[i], "-machine") == 0 && i + 1 < argc) {
+            fe->machine = MachineFind(argv[++i]);
+        } else if (strcmp(argv[i], "-journal") == 0 && i + 1 < argc) {
+            fe->journal_path = argv[++i];
+        } else if (strcmp(argv[i], "-runahead") == 0 && i + 1 < argc) {
+            fe->runahead_frames = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-metrics") == 0 && i + 1 < argc) {
+            fe->metrics_address = argv[++i];
+        } else if (strcmp(argv[i], "-dip") == 0 && i + 1 < argc && fe->ndips < MAX_DIPS) {
+            fe->dips[fe->ndips++] = argv[++i];
+        } else if (strcmp(argv[i], "-capture") == 0 && i + 1 < argc) {
+            fe->capture = argv[++i];
+        } else if (strcmp(argv[i], "-frames") == 0 && i + 1 < argc) {
+            fe->max_frames = strtoull(argv[++i], NULL, 10);
+        } else {
+            Usage(argv[0], help);
+        }
+    }
+
+    if (fe->runahead_frames > 0 && (fe->debug_address || fe->trace_path)) {
+        printf("error: -runahead can't be combined with -gdb or -trace\n");
+        exit(1);
+    }
+}
+
+// Loads the machine and sets up everything the options ask for. With
+// -gdb this waits for the debugger to connect.
+void FrontendInit(Frontend *fe) {
+    State8080 *state = Init8080();
+    fe->state = state;
+    if (fe->idle_skip)
+        state->idle = IdleCreate();
+    fe->cache = fe->fuse ? DecodeCacheCreate() : NULL;
+    fe->journal = fe->journal_path ? JournalLoad(fe->journal_path) : NULL;
+
+    SchedulerInit(&fe->sched);
+    VideoInit(&fe->video, fe->machine, state, &fe->sched);
+    MachineLoad(fe->machine, state);
+    for (int i = 0; i < fe->ndips; i++)
+        MachineSetDip(fe->machine, state, fe->dips[i]);
+    if (fe->metrics_address) {
+        fe->counters = CountersCreate("main");
+        state->counters = fe->counters;
+        MetricsServe(fe->metrics_address);
+    }
+    if (fe->runahead_frames > 0)
+        fe->runahead = RunAheadCreate(state, fe->cache, fe->runahead_frames);
+
+    if (fe->debug_address)
+        fe->debugger = DebugCreate(fe->debug_address);
+    // Tracing records every instruction, so it bypasses idle skipping
+    if (fe->trace_path)
+        fe->trace = TraceCreate(fe->trace_path);
+}
+
+// Writes the frame buffer as <prefix><frame>.pbm
+static void CaptureFrame(const char *prefix, uint64_t frame, const VideoFormat *video, const uint8_t *vram)
+{
+    char path[1024];
+    snprintf(path, sizeof(path), "%s%06llu.pbm", prefix, (unsigned long long) frame);
+    WriteFramePBM(path, video, vram);
+}
+
+// Runs to the end of the next frame. The debugger and the tracer step the
+// CPU themselves, a slice at a time; otherwise it is MachineRunFrame.
+// Returns 0 if the CPU has stopped for good instead.
+static int RunFrame(Frontend *fe)
+{
+    State8080 *state = fe->state;
+    if (!fe->debugger && !fe->trace)
+        return MachineRunFrame(state, fe->cache, &fe->sched, &fe->video);
+
+    while (!fe->video.frame_done) {
+        uint64_t next_event = SchedulerNext(&fe->sched);
+        if (fe->debugger)
+            DebugPoll(fe->debugger, state);
+        if (fe->debugger && fe->debugger->armed)
+            DebugRun(fe->debugger, state, next_event);
+        else if (fe->trace)
+            TraceRun(fe->trace, state, next_event);
+        else if (fe->cache)
+            Run8080Fused(state, fe->cache, next_event);
+        else
+            Run8080Slice(state, next_event);
+        SchedulerRunDue(&fe->sched, state->cycles);
+        if (state->halted && !state->int_enable)
+            return 0;
+    }
+    fe->video.frame_done = 0;
+    return 1;
+}
+
+static void Report(Frontend *fe)
+{
+    State8080 *state = fe->state;
+    PacerReport(&fe->pacer, stdout);
+    printf("frames drawn %llu skipped %llu\n", (unsigned long long) fe->frameskip.drawn,
+           (unsigned long long) fe->frameskip.skipped);
+    if (state->idle)
+        printf("idle loops skipped %llu times, %.1f%% of cycles\n",
+               (unsigned long long) state->idle->skips,
+               100.0 * state->idle->skipped_cycles / state->cycles);
+    if (fe->report)
+        fe->report(fe, fe->ctx);
+    if (fe->runahead)
+        RunAheadReport(fe->runahead, stdout);
+}
+
+// Runs until -frames, the CPU stopping for good or `quit`
+void FrontendRun(Frontend *fe) {
+    State8080 *state = fe->state;
+    const VideoFormat *format = &fe->machine->video;
+
+    PacerInit(&fe->pacer, fe->pace_mode, fe->pace_multiplier, FRAMES_PER_SECOND);
+    FrameSkipInit(&fe->frameskip, fe->skip_mode, fe->skip);
+    if (fe->journal)
+        JournalReplay(fe->journal, state, 0);
+    uint64_t frame_start = PacerNow();
+    while (!fe->quit) {
+        if (!RunFrame(fe)) {
+            printf("CPU halted with interrupts disabled at $%04x\n", state->pc - 1);
+            break;
+        }
+
+        // The next frame's input goes in first, so run-ahead sees it
+        if (fe->journal)
+            JournalReplay(fe->journal, state, fe->pacer.frames + 1);
+        // Skipped frames never touch the frame buffer or the screen
+        if (FrameSkipShouldDraw(&fe->frameskip, &fe->pacer)) {
+            // Show where the current input leads, then take it back
+            if (fe->runahead)
+                RunAheadBegin(fe->runahead, state, &fe->sched, &fe->video);
+            if (fe->capture)
+                CaptureFrame(fe->capture, fe->pacer.frames, format, &state->memory[format->base]);
+            if (fe->present)
+                fe->present(fe, fe->ctx);
+            if (fe->runahead)
+                RunAheadEnd(fe->runahead, state, &fe->sched, &fe->video);
+        }
+
+        // Host time for the frame, not counting the wait for the pacer
+        if (fe->counters)
+            CountersFrame(fe->counters, PacerNow() - frame_start);
+        PacerFrame(&fe->pacer);
+        frame_start = PacerNow();
+        if (fe->show_stats && fe->pacer.frames % (5 * FRAMES_PER_SECOND) == 0)
+            Report(fe);
+        if (fe->max_frames && fe->pacer.frames >= fe->max_frames)
+            fe->quit = 1;
+    }
+}
+
+void FrontendClose(Frontend *fe) {
+#ifdef PROFILE
+    ProfileReport(fe->state->memory, 40);
+#endif
+    // The totals, unless the last frame's periodic stats just gave them
+    if (fe->show_stats && fe->pacer.frames % (5 * FRAMES_PER_SECOND) != 0)
+        Report(fe);
+    if (fe->trace)
+        TraceClose(fe->trace);
+}
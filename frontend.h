@@ -0,0 +1,74 @@
+#ifndef FRONTEND_H
+#define FRONTEND_H
+
+#include <stdint.h>
+#include "cpu8080.h"
+#include "scheduler.h"
+#include "pacing.h"
+#include "frameskip.h"
+#include "fused.h"
+#include "debug.h"
+#include "trace.h"
+#include "machine.h"
+#include "journal.h"
+#include "runahead.h"
+#include "counters.h"
+
+// The machine loop the SDL frontend and the headless runner share: their
+// options, and frame after frame the debugger or tracer, the journal,
+// frame skipping, run-ahead, capture, metrics and stats. A frontend adds
+// only how a frame is shown and what else the stats report.
+//
+//   FrontendParse(&fe, argc, argv, PACE_MAX, NULL);
+//   FrontendInit(&fe);
+//   fe.present = ...;
+//   FrontendRun(&fe);
+//   FrontendClose(&fe);
+
+struct Frontend;
+typedef void (*FrontendHook)(struct Frontend *fe, void *ctx);
+
+typedef struct Frontend {
+    // Options
+    PaceMode pace_mode;
+    double pace_multiplier;
+    int show_stats;
+    SkipMode skip_mode;
+    int skip;
+    const char *capture;
+    uint64_t max_frames;
+    int fuse;
+    int idle_skip;
+    const char *debug_address;
+    const char *trace_path;
+    const char *journal_path;
+    const char *metrics_address;
+    const Machine *machine;
+    const char *dips[MAX_DIPS];
+    int ndips;
+    int runahead_frames;
+
+    State8080 *state;
+    Scheduler sched;
+    Pacer pacer;
+    FrameSkip frameskip;
+    DecodeCache *cache;     // NULL runs the slice core
+    Debugger *debugger;
+    Trace *trace;
+    Journal *journal;
+    Video video;
+    RunAhead *runahead;
+    Counters *counters;
+    int quit;               // set to stop after the current frame
+
+    FrontendHook present;   // shows a drawn frame, from VRAM
+    FrontendHook report;    // adds to the stats
+    void *ctx;
+} Frontend;
+
+void FrontendParse(Frontend *fe, int argc, char **argv, PaceMode pace_mode, const char *help);
+void FrontendInit(Frontend *fe);
+void FrontendRun(Frontend *fe);
+void FrontendClose(Frontend *fe);
+
+#endif
@@ -0,0 +1,191 @@
+#include <stdlib.h>
+#include "fused.h"
+#include "idle.h"
+#include "counters.h"
+#include "ops8080.h"
+
+// Sequences are matched longest first. The list was read off the copy,
+// clear and counted loops of the Space Invaders listing, not measured;
+// fusetune.sh profiles the game and the CP/M programs to retune it from.
+typedef struct Pattern {
+    uint8_t kind;
+    uint8_t length;             // bytes covered, including operands
+    uint8_t ops;                // opcode bytes to match
+    uint8_t code[4];
+} Pattern;
+
+static const Pattern patterns[] = {
+    {FUSE_COPY_DE_TO_HL, 4, 4, {0x1a, 0x77, 0x23, 0x13}},
+    {FUSE_DCR_B_JNZ,     4, 2, {0x05, 0xc2}},
+    {FUSE_DCR_C_JNZ,     4, 2, {0x0d, 0xc2}},
+    {FUSE_MOV_A_M_INX_H, 2, 2, {0x7e, 0x23}},
+    {FUSE_MOV_M_A_INX_H, 2, 2, {0x77, 0x23}},
+    {FUSE_LDAX_D_INX_D,  2, 2, {0x1a, 0x13}},
+};
+
+DecodeCache *DecodeCacheCreate(void) {
+    return calloc(1, sizeof(DecodeCache));
+}
+
+// The next four bytes. Like MapFetch, they are read through the map one
+// at a time only when they cross a page.
+static inline uint32_t Fetch32(const State8080 *state, uint16_t pc)
+{
+    if ((pc & 0xff) <= 0xfc) {
+        const uint8_t *p = &state->memory[state->map->read[pc >> 8] | (pc & 0xff)];
+        return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t) p[3] << 24;
+    }
+    return MemRead(state, pc) |
+           MemRead(state, pc + 1) << 8 |
+           MemRead(state, pc + 2) << 16 |
+           (uint32_t) MemRead(state, pc + 3) << 24;
+}
+
+// Drops the entries of a written page. Entries that run into the next
+// page are checked against memory each time they run instead, as the next
+// page may be mapped anywhere.
+static void Invalidate(DecodeCache *cache, MemoryMap *map, uint32_t page)
+{
+    for (uint32_t i = page << 8; i < (page + 1) << 8; i++)
+        cache->entry[i].valid = 0;
+    map->dirty[page] &= ~DIRTY_CODE;
+}
+
+static inline uint32_t LengthMask(int length)
+{
+    return length >= 4 ? 0xffffffff : (1u << (8 * length)) - 1;
+}
+
+// Whether the sequence stores to one of its own later bytes, which it
+// has already read. Only the stores through HL do, before HL moves, so
+// HL now is the address; it is compared in the backing array, as it may
+// be a mirror of the code.
+static int StoresAhead(const State8080 *state, const Decoded *d)
+{
+    if (d->kind != FUSE_MOV_M_A_INX_H && d->kind != FUSE_COPY_DE_TO_HL)
+        return 0;
+    const MemoryMap *map = state->map;
+    uint16_t hl = state->h << 8 | state->l;
+    uint32_t target = map->write[hl >> 8] | (hl & 0xff);
+    for (int i = 1; i < d->length; i++) {
+        uint16_t addr = state->pc + i;
+        if ((map->read[addr >> 8] | (addr & 0xff)) == target)
+            return 1;
+    }
+    return 0;
+}
+
+static void Decode(Decoded *d, uint32_t bytes)
+{
+    d->kind = FUSE_NONE;
+    d->length = 1;
+    d->cycles = 0;
+    for (size_t i = 0; i < sizeof(patterns) / sizeof(patterns[0]); i++) {
+        const Pattern *p = &patterns[i];
+        int match = 1;
+        for (int j = 0; j < p->ops; j++) {
+            if (((bytes >> (8 * j)) & 0xff) != p->code[j])
+                match = 0;
+        }
+        if (!match)
+            continue;
+        d->kind = p->kind;
+        d->length = p->length;
+        for (int j = 0; j < p->ops; j++)
+            d->cycles += cycles8080[p->code[j]];
+        break;
+    }
+    d->bytes = bytes & LengthMask(d->length);
+    d->valid = 1;
+}
+
+// Runs the CPU until the cycle counter reaches `until`. A superinstruction
+// that would cross `until` is executed one opcode at a time instead, so
+// scheduled events are delivered at the same cycle as with Emulate8080Op.
+void Run8080Fused(State8080 *state, DecodeCache *cache, uint64_t until) {
+#if defined(TRACE) || defined(PROFILE)
+    // tracing and profiling need to see every opcode
+    (void) cache;
+    Run8080(state, until);
+    return;
+#endif
+    MemoryMap *map = state->map;
+    uint64_t start_cycles = state->cycles, retired = 0, misses = 0, lookups = 0;
+    while (state->cycles < until) {
+        if (state->halted) {
+            if (state->int_enable)
+                state->cycles = until;
+            break;
+        }
+        uint32_t offset = map->read[state->pc >> 8] | (state->pc & 0xff);
+        if (map->dirty[offset >> 8] & DIRTY_CODE)
+            Invalidate(cache, map, offset >> 8);
+        Decoded *d = &cache->entry[offset];
+        lookups++;
+        if (d->valid && (state->pc & 0xff) + d->length > 0x100 &&
+            d->bytes != (Fetch32(state, state->pc) & LengthMask(d->length)))
+            d->valid = 0;
+        if (!d->valid) {
+            Decode(d, Fetch32(state, state->pc));
+            misses++;
+        }
+
+        // A store into the sequence is left to the next lookup to see
+        if (d->kind == FUSE_NONE || state->cycles + d->cycles > until || StoresAhead(state, d)) {
+            IdleOnOpcode(state, until);
+            Emulate8080Op(state);
+            retired++;
+            continue;
+        }
+
+        // Each opcode of the sequence runs its handler from the table, with
+        // `opcode` and PC set up as Emulate8080Op would
+        const uint8_t code[4] = {d->bytes, d->bytes >> 8, d->bytes >> 16, d->bytes >> 24};
+        uint16_t start = state->pc;
+        const uint8_t *opcode;
+#define STEP(offset, handler) do { \
+            opcode = &code[offset]; \
+            state->pc = start + (offset) + 1; \
+            handler; \
+            retired++; \
+        } while (0)
+        // The register macros stay defined to the end of the file
+#include "state8080.inc"
+        switch (d->kind) {
+            case FUSE_MOV_A_M_INX_H:
+                STEP(0, OP_MOV(A, READ8(HL)));
+                STEP(1, OP_INX(HL, SET_HL));
+                break;
+            case FUSE_MOV_M_A_INX_H:
+                STEP(0, OP_STORE_M(A));
+                STEP(1, OP_INX(HL, SET_HL));
+                break;
+            case FUSE_LDAX_D_INX_D:
+                STEP(0, OP_LDAX(DE));
+                STEP(1, OP_INX(DE, SET_DE));
+                break;
+            case FUSE_COPY_DE_TO_HL:
+                STEP(0, OP_LDAX(DE));
+                STEP(1, OP_STORE_M(A));
+                STEP(2, OP_INX(HL, SET_HL));
+                STEP(3, OP_INX(DE, SET_DE));
+                break;
+            case FUSE_DCR_B_JNZ:
+                STEP(0, OP_DCR(B));
+                STEP(1, OP_JCOND(!CC.z));
+                break;
+            case FUSE_DCR_C_JNZ:
+                STEP(0, OP_DCR(C));
+                STEP(1, OP_JCOND(!CC.z));
+                break;
+        }
+#undef STEP
+        state->cycles += d->cycles;
+    }
+    if (state->counters) {
+        COUNT(state->counters->instructions, retired);
+        COUNT(state->counters->cycles, state->cycles - start_cycles);
+        COUNT(state->counters->decode_hits, lookups - misses);
+        COUNT(state->counters->decode_misses, misses);
+    }
+}
@@ -0,0 +1,37 @@
+#ifndef FUSED_H
+#define FUSED_H
+
+#include <stdint.h>
+#include "cpu8080.h"
+
+// Superinstructions: common opcode sequences executed by one handler.
+// FUSE_NONE entries fall back to Emulate8080Op.
+enum {
+    FUSE_NONE,
+    FUSE_MOV_A_M_INX_H,         // 7e 23
+    FUSE_MOV_M_A_INX_H,         // 77 23
+    FUSE_LDAX_D_INX_D,          // 1a 13
+    FUSE_COPY_DE_TO_HL,         // 1a 77 23 13  LDAX D; MOV M,A; INX H; INX D
+    FUSE_DCR_B_JNZ,             // 05 c2 lo hi
+    FUSE_DCR_C_JNZ,             // 0d c2 lo hi
+};
+
+// One pre-decoded entry per byte of backing memory, so mirrors share
+// them. Entries are dropped when the memory map reports a write to their
+// page through DIRTY_CODE; only one cache may run against a given map.
+typedef struct Decoded {
+    uint32_t bytes;
+    uint8_t kind;
+    uint8_t length;
+    uint8_t cycles;
+    uint8_t valid;
+} Decoded;
+
+typedef struct DecodeCache {
+    Decoded entry[0x10000];
+} DecodeCache;
+
+DecodeCache *DecodeCacheCreate(void);
+void Run8080Fused(State8080 *state, DecodeCache *cache, uint64_t until);
+
+#endif
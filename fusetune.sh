@@ -0,0 +1,49 @@
+#!/bin/sh
+# Profiles and times the fused core on the real workloads, to retune the
+# pattern list in fused.c. A PROFILE build runs the invaders gameplay
+# replay and every CP/M program in rom-dir and prints their hottest opcode
+# pairs, the candidates for superinstructions; a release build then runs
+# the same workloads on the slice and fused cores.
+#
+#   ./fusetune.sh [rom-dir]
+#
+# Workloads whose files are not in rom-dir (default: the source
+# directory) are skipped.
+set -e
+
+src=$(cd "$(dirname "$0")" && pwd)
+roms=$(cd "${1:-$src}" && pwd)
+profile="$src/build/profile"
+release="$src/build/release"
+
+cd "$src"
+cmake -S "$src" -B "$profile" -DCMAKE_BUILD_TYPE=Release -DEMU8080_PROFILE=ON >/dev/null
+cmake --build "$profile" -j >/dev/null
+cmake --preset release >/dev/null
+cmake --build --preset release -j >/dev/null
+
+pairs() {
+    sed -n '/^hot opcode pairs:/,/^$/p'
+}
+
+if [ -f "$roms/invaders.h" ]; then
+    echo "== invaders, play.journal"
+    (cd "$roms" && "$profile/emu8080-headless" -journal "$src/tests/play.journal" -frames 1800) | pairs
+    for core in slice fused; do
+        flag=$([ $core = slice ] && echo -nofuse || true)
+        printf '%s core: ' $core
+        (cd "$roms" && "$release/emu8080-headless" -journal "$src/tests/play.journal" -frames 1800 \
+                                                   -stats $flag) | grep '^speed' | tail -n 1
+    done
+else
+    echo "fusetune: no ROMs in $roms, skipping invaders"
+fi
+
+for com in "$roms"/*.com; do
+    [ -f "$com" ] || continue
+    echo "== $(basename "$com")"
+    (cd "$roms" && "$profile/cpm8080" "$com" </dev/null) | pairs
+    for core in slice fused; do
+        (cd "$roms" && "$release/cpm8080" -core $core -stats "$com" </dev/null 2>&1 >/dev/null) | tail -n 1
+    done
+done
@@ -0,0 +1,378 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cpu8080.h"
+#include "fused.h"
+#include "idle.h"
+#include "pacing.h"
+#include "trace.h"
+
+// Differential fuzzer. Each case is a random machine state with a short
+// random instruction stream at PC. The stream is stepped once through
+// Emulate8080Op as the reference, then every core runs the same state for
+// the same number of cycles and must end with identical registers, flags,
+// cycle count and memory.
+//
+//   fuzz8080 [-seed N] [-cases N] [-seconds N] [-trace file]
+//
+// Fixed cases of self-modifying code the fused core must notice run
+// first.
+//
+// -trace records the reference steps of every case, which makes a trace
+// with large PC and SP jumps for testing the trace encoder.
+//
+// Built with -DLIBFUZZER it is a libFuzzer target instead, taking the
+// case from the fuzzer's input:
+//
+//   clang -g -O1 -fsanitize=fuzzer,address -DLIBFUZZER fuzz8080.c cpu8080.c ...
+
+#define MAX_STEPS 32
+
+typedef void (*RunFunc)(State8080 *state, uint64_t until);
+
+static DecodeCache *decode_cache;
+static IdleDetector *idle_detector;
+
+static void RunSwitch(State8080 *state, uint64_t until)
+{
+    Run8080(state, until);
+}
+
+static void RunSlice(State8080 *state, uint64_t until)
+{
+    Run8080Slice(state, until);
+}
+
+static void RunFused(State8080 *state, uint64_t until)
+{
+    Run8080Fused(state, decode_cache, until);
+}
+
+static void RunIdle(State8080 *state, uint64_t until)
+{
+    state->idle = idle_detector;
+    Run8080(state, until);
+    state->idle = NULL;
+}
+
+// Every core is compared against the reference. New cores go here.
+static const struct {
+    const char *name;
+    RunFunc run;
+} cores[] = {
+    {"switch", RunSwitch},
+    {"slice", RunSlice},
+    {"fused", RunFused},
+    {"idle", RunIdle},
+};
+
+#define NCORES (sizeof(cores) / sizeof(cores[0]))
+
+// Case bytes come from the fuzzer input while it lasts, then from a
+// xorshift generator seeded by it
+typedef struct Source {
+    const uint8_t *data;
+    size_t size;
+    size_t pos;
+    uint64_t rng;
+} Source;
+
+// IN reads a value that depends only on the port, OUT is dropped
+static uint8_t FuzzIn(State8080 *state, uint8_t port)
+{
+    return port * 0x1d ^ 0xa5;
+}
+
+static uint64_t Random(Source *src)
+{
+    src->rng ^= src->rng << 13;
+    src->rng ^= src->rng >> 7;
+    src->rng ^= src->rng << 17;
+    return src->rng;
+}
+
+static uint8_t Byte(Source *src)
+{
+    if (src->pos < src->size)
+        return src->data[src->pos++];
+    return (uint8_t) Random(src);
+}
+
+static uint8_t reference_memory[0x10000];
+static State8080 reference, start;
+static State8080 *machine[NCORES];
+static uint64_t cases, steps, failures;
+static Trace *trace;
+static int mirrored;    // 0x4000-0x7fff mirrors 0x0000-0x3fff
+
+static void Generate(Source *src)
+{
+    mirrored = 0;
+    uint64_t *words = (uint64_t *) reference_memory;
+    for (int i = 0; i < 0x10000 / 8; i++)
+        words[i] = Random(src);
+
+    memset(&start, 0, sizeof(start));
+    start.port_in = FuzzIn;
+    start.port_out = PortOutNone;
+    start.a = Byte(src);
+    start.b = Byte(src);
+    start.c = Byte(src);
+    start.d = Byte(src);
+    start.e = Byte(src);
+    start.h = Byte(src);
+    start.l = Byte(src);
+    uint8_t flags = Byte(src);
+    start.cc.z = flags;
+    start.cc.s = flags >> 1;
+    start.cc.p = flags >> 2;
+    start.cc.cy = flags >> 3;
+    start.cc.ac = flags >> 4;
+    start.int_enable = flags >> 5 & 1;
+    start.sp = Byte(src) | Byte(src) << 8;
+    start.pc = Byte(src) | Byte(src) << 8;
+
+    // Loops are what the fused and idle cores care about, so some
+    // jumps are pointed back into the stream
+    uint16_t pc = start.pc;
+    int n = 1 + Byte(src) % MAX_STEPS;
+    for (int i = 0; i < n; i++) {
+        uint8_t op = Byte(src);
+        reference_memory[pc] = op;
+        for (int j = 1; j < length8080[op]; j++)
+            reference_memory[(uint16_t) (pc + j)] = Byte(src);
+        if (length8080[op] == 3 && (Byte(src) & 3) == 0) {
+            uint16_t target = start.pc + Byte(src) % (uint16_t) (pc - start.pc + 1);
+            reference_memory[(uint16_t) (pc + 1)] = target & 0xff;
+            reference_memory[(uint16_t) (pc + 2)] = target >> 8;
+        }
+        pc += length8080[op];
+    }
+}
+
+// A flat map also marks every page dirty, which empties the fused cache
+static void Reset(State8080 *state, uint8_t *memory, MemoryMap *map)
+{
+    *state = start;
+    state->memory = memory;
+    state->map = map;
+    MemoryMapFlat(map);
+    if (mirrored)
+        MemoryMapRange(map, 0x4000, 0x4000, 0x0000, 1);
+    memcpy(memory, reference_memory, 0x10000);
+}
+
+static void Report(const char *name, const State8080 *x, const State8080 *y)
+{
+    printf("%-9s pc=%04x sp=%04x a=%02x b=%02x c=%02x d=%02x e=%02x h=%02x l=%02x "
+           "z=%d s=%d p=%d cy=%d ac=%d ei=%d hlt=%d cycles=%llu\n",
+           name, x->pc, x->sp, x->a, x->b, x->c, x->d, x->e, x->h, x->l,
+           x->cc.z, x->cc.s, x->cc.p, x->cc.cy, x->cc.ac, x->int_enable, x->halted,
+           (unsigned long long) x->cycles);
+    for (int addr = 0; y && addr < 0x10000; addr++) {
+        if (x->memory[addr] != y->memory[addr]) {
+            printf("%-9s memory differs first at $%04x: %02x, reference %02x\n",
+                   name, addr, x->memory[addr], y->memory[addr]);
+            break;
+        }
+    }
+}
+
+static int SameState(const State8080 *x, const State8080 *y)
+{
+    return x->a == y->a && x->b == y->b && x->c == y->c && x->d == y->d &&
+           x->e == y->e && x->h == y->h && x->l == y->l && x->sp == y->sp &&
+           x->pc == y->pc && x->cycles == y->cycles &&
+           x->cc.z == y->cc.z && x->cc.s == y->cc.s && x->cc.p == y->cc.p &&
+           x->cc.cy == y->cc.cy && x->cc.ac == y->cc.ac &&
+           x->int_enable == y->int_enable && x->halted == y->halted &&
+           memcmp(x->memory, y->memory, 0x10000) == 0;
+}
+
+typedef struct Code {
+    uint16_t addr;
+    uint8_t code[4];
+    int length;
+} Code;
+
+// Zeroed memory and registers with the program loaded, starting at `pc`
+static void Load(const Code *program, size_t n, uint16_t pc)
+{
+    memset(reference_memory, 0, sizeof(reference_memory));
+    for (size_t i = 0; i < n; i++)
+        memcpy(&reference_memory[program[i].addr], program[i].code, program[i].length);
+    memset(&start, 0, sizeof(start));
+    start.port_in = FuzzIn;
+    start.port_out = PortOutNone;
+    start.pc = pc;
+    mirrored = 1;
+}
+
+// A loop whose DCR B / JNZ straddles a page, with the jump target on the
+// second page patched each time round through the mirror: the cached
+// superinstruction goes stale without its own page being written.
+static void GeneratePatch(void)
+{
+    static const Code program[] = {
+        {0x2000, {0x31, 0x00, 0x30}, 3},        // LXI SP,$3000
+        {0x2003, {0x06, 0x03}, 2},              // MVI B,3
+        {0x2005, {0xc3, 0xf0, 0x20}, 3},        // JMP $20f0
+        {0x20e0, {0x0c}, 1},                    // INR C
+        {0x20e1, {0xc3, 0xf0, 0x20}, 3},        // JMP $20f0
+        {0x20f0, {0x3a, 0x00, 0x61}, 3},        // LDA $6100
+        {0x20f3, {0xee, 0x10}, 2},              // XRI $10
+        {0x20f5, {0x32, 0x00, 0x61}, 3},        // STA $6100, the JNZ target
+        {0x20fe, {0x05, 0xc2, 0xf0, 0x20}, 4},  // DCR B; JNZ $20f0
+        {0x2102, {0x76}, 1},                    // HLT
+    };
+    Load(program, sizeof(program) / sizeof(program[0]), 0x2000);
+}
+
+// Superinstructions whose store lands on one of their own later opcodes,
+// directly and through the mirror: the rest must run the new opcode.
+static void GenerateStoreAhead(void)
+{
+    static const Code program[] = {
+        {0x0100, {0x77, 0x23}, 2},              // MOV M,A; INX H, HL=$0101
+        {0x0102, {0x47}, 1},                    // MOV B,A
+        {0x0103, {0x21, 0x0b, 0x41}, 3},        // LXI H,$410b
+        {0x0106, {0x11, 0x00, 0x03}, 3},        // LXI D,$0300
+        {0x0109, {0x1a, 0x77, 0x23, 0x13}, 4},  // LDAX D; MOV M,A; INX H; INX D
+        {0x010d, {0x76}, 1},                    // HLT
+    };
+    Load(program, sizeof(program) / sizeof(program[0]), 0x0100);
+    start.a = 0x3c;                             // INR A over the INX H
+    start.h = 0x01;
+    start.l = 0x01;
+}
+
+typedef void (*FixedCase)(void);
+
+// Cases the random ones are unlikely to hit, run before them
+static const FixedCase fixed_cases[] = {GeneratePatch, GenerateStoreAhead};
+
+// Returns 0 when every core agrees with the reference. Without a source
+// it runs the fixed case.
+static int RunCase(Source *src, FixedCase fixed)
+{
+    static uint8_t memory[NCORES + 1][MEMORY_ALLOC];
+    static MemoryMap map[NCORES + 1];
+    int failed = 0;
+
+    if (src)
+        Generate(src);
+    else
+        fixed();
+
+    // The reference steps one opcode at a time, which fixes the cycle
+    // budget for the cores
+    Reset(&reference, memory[NCORES], &map[NCORES]);
+    for (int i = 0; i < MAX_STEPS * 2 && !reference.halted; i++) {
+        if (trace) {
+            TraceRecord rec;
+            TraceCapture(&reference, &rec);
+            TraceAppend(trace, &rec);
+        }
+        Emulate8080Op(&reference);
+        steps++;
+    }
+    uint64_t budget = reference.cycles;
+
+    for (size_t i = 0; i < NCORES; i++) {
+        Reset(machine[i], memory[i], &map[i]);
+        cores[i].run(machine[i], budget);
+        if (!SameState(machine[i], &reference)) {
+            if (!failed) {
+                printf("case %llu diverges\n", (unsigned long long) cases);
+                Report("start", &start, NULL);
+                Report("reference", &reference, NULL);
+            }
+            Report(cores[i].name, machine[i], &reference);
+            failed = 1;
+        }
+    }
+    cases++;
+    failures += failed;
+    return failed;
+}
+
+static void Setup(void)
+{
+    static State8080 states[NCORES];
+    for (size_t i = 0; i < NCORES; i++)
+        machine[i] = &states[i];
+    decode_cache = DecodeCacheCreate();
+    idle_detector = IdleCreate();
+}
+
+#ifdef LIBFUZZER
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    static int ready;
+    if (!ready) {
+        Setup();
+        ready = 1;
+    }
+    Source src = {data, size, 0, 0x9e3779b97f4a7c15ull};
+    for (size_t i = 0; i < size; i++)
+        src.rng = (src.rng ^ data[i]) * 0x100000001b3ull;
+    if (src.rng == 0)
+        src.rng = 1;
+    if (RunCase(&src, NULL))
+        abort();
+    return 0;
+}
+
+#else
+
+int main(int argc, char **argv) {
+    uint64_t seed = 1, max_cases = 100000;
+    double seconds = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-seed") == 0 && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "-cases") == 0 && i + 1 < argc) {
+            max_cases = strtoull(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "-seconds") == 0 && i + 1 < argc) {
+            seconds = atof(argv[++i]);
+            max_cases = 0;
+        } else if (strcmp(argv[i], "-trace") == 0 && i + 1 < argc) {
+            trace = TraceCreate(argv[++i]);
+        } else {
+            printf("usage: %s [-seed N] [-cases N] [-seconds N] [-trace file]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    Setup();
+    for (size_t i = 0; i < sizeof(fixed_cases) / sizeof(fixed_cases[0]); i++)
+        RunCase(NULL, fixed_cases[i]);
+    Source src = {NULL, 0, 0, seed ? seed : 1};
+    uint64_t t0 = PacerNow(), now = t0, last_report = t0;
+    while (failures < 10) {
+        if (max_cases && cases >= max_cases)
+            break;
+        RunCase(&src, NULL);
+        if ((cases & 1023) == 0) {
+            now = PacerNow();
+            if (seconds > 0 && now - t0 >= seconds * 1e9)
+                break;
+            if (now - last_report >= 10000000000ull) {
+                printf("%llu cases, %.0f states/s\n", (unsigned long long) cases,
+                       cases * NCORES / ((now - t0) / 1e9));
+                last_report = now;
+            }
+        }
+    }
+    now = PacerNow();
+    printf("%llu cases, %llu instructions, %llu failures, %.0f states/s over %d cores\n",
+           (unsigned long long) cases, (unsigned long long) steps,
+           (unsigned long long) failures, cases * NCORES / ((now - t0) / 1e9), (int) NCORES);
+    printf("idle loops skipped %llu times\n", (unsigned long long) idle_detector->skips);
+    if (trace)
+        TraceClose(trace);
+    return failures != 0;
+}
+
+#endif
@@ -0,0 +1,239 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cpu8080.h"
+#include "scheduler.h"
+#include "fused.h"
+#include "idle.h"
+#include "pacing.h"
+#include "machine.h"
+#include "journal.h"
+#include "rewind.h"
+
+// Golden-frame test. Runs a machine's ROMs (invaders by default) headless
+// and as fast as possible, replays an input journal, and hashes the frame
+// buffer at the frames listed in a golden file, one "frame hash" line
+// each. A mismatching frame is written out as a PBM.
+//
+//   golden [-machine name] [-journal file] [-dump prefix] golden.txt
+//   golden [-machine name] [-journal file] -record N,N,... golden.txt
+//
+// With -rewind, a snapshot is taken every so many frames into a buffer of
+// -rewind-kb (default 4096). After the run, each golden frame is reached
+// again by rewinding and replaying the journal, and checked once more.
+//
+// The frames per millisecond it reports make it a whole-system benchmark.
+
+#define MAX_GOLDEN 1024
+
+typedef struct Golden {
+    uint64_t frame;
+    uint64_t hash;
+} Golden;
+
+static Golden golden[MAX_GOLDEN];
+static int ngolden;
+
+// FNV-1a
+static uint64_t HashFrame(const VideoFormat *video, const uint8_t *vram)
+{
+    uint64_t h = 0xcbf29ce484222325ull;
+    for (uint32_t i = 0; i < VideoBytes(video); i++) {
+        h ^= vram[i];
+        h *= 0x100000001b3ull;
+    }
+    return h;
+}
+
+// Hashes the frame buffer and writes it out as a PBM when the hash is not
+// the golden one. Returns 1 on a mismatch.
+static int CheckFrame(const Machine *machine, const State8080 *state, const Golden *g,
+                      const char *dump, const char *what)
+{
+    const uint8_t *vram = &state->memory[machine->video.base];
+    uint64_t hash = HashFrame(&machine->video, vram);
+    if (hash == g->hash)
+        return 0;
+    char path[1024];
+    snprintf(path, sizeof(path), "%s%s%06llu.pbm", dump, what, (unsigned long long) g->frame);
+    WriteFramePBM(path, &machine->video, vram);
+    printf("%sframe %llu: hash %016llx, expected %016llx, written to %s\n", what,
+           (unsigned long long) g->frame, (unsigned long long) hash,
+           (unsigned long long) g->hash, path);
+    return 1;
+}
+
+static void AddGolden(uint64_t frame, uint64_t hash)
+{
+    if (ngolden == MAX_GOLDEN) {
+        printf("error: more than %d golden frames\n", MAX_GOLDEN);
+        exit(1);
+    }
+    // Frame N is the picture after N frames have run, so there is no 0
+    if (frame == 0) {
+        printf("error: golden frames are numbered from 1\n");
+        exit(1);
+    }
+    if (ngolden > 0 && frame <= golden[ngolden - 1].frame) {
+        printf("error: golden frames must be in increasing order\n");
+        exit(1);
+    }
+    golden[ngolden].frame = frame;
+    golden[ngolden].hash = hash;
+    ngolden++;
+}
+
+static void LoadGolden(const char *path)
+{
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        printf("error: Couldn't open %s\n", path);
+        exit(1);
+    }
+    char line[256];
+    while (fgets(line, sizeof(line), f)) {
+        unsigned long long frame, hash;
+        if (line[0] == '#')
+            continue;
+        if (sscanf(line, "%llu %llx", &frame, &hash) == 2)
+            AddGolden(frame, hash);
+    }
+    fclose(f);
+}
+
+static void SaveGolden(const char *path, const char *journal)
+{
+    FILE *f = fopen(path, "w");
+    if (f == NULL) {
+        printf("error: Couldn't open %s\n", path);
+        exit(1);
+    }
+    fprintf(f, "# frame hash, journal %s\n", journal ? journal : "none");
+    for (int i = 0; i < ngolden; i++)
+        fprintf(f, "%llu %016llx\n", (unsigned long long) golden[i].frame,
+                (unsigned long long) golden[i].hash);
+    fclose(f);
+}
+
+int main(int argc, char **argv) {
+    const char *journal_path = NULL;
+    const char *dump = "golden-";
+    const char *record = NULL;
+    const char *golden_path = NULL;
+    const Machine *machine = &machines[0];
+    int rewind_interval = 0;
+    size_t rewind_kb = 4096;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-machine") == 0 && i + 1 < argc) {
+            machine = MachineFind(argv[++i]);
+        } else if (strcmp(argv[i], "-journal") == 0 && i + 1 < argc) {
+            journal_path = argv[++i];
+        } else if (strcmp(argv[i], "-rewind") == 0 && i + 1 < argc) {
+            rewind_interval = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-rewind-kb") == 0 && i + 1 < argc) {
+            rewind_kb = strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "-dump") == 0 && i + 1 < argc) {
+            dump = argv[++i];
+        } else if (strcmp(argv[i], "-record") == 0 && i + 1 < argc) {
+            record = argv[++i];
+        } else if (argv[i][0] != '-' && golden_path == NULL) {
+            golden_path = argv[i];
+        } else {
+            golden_path = NULL;
+            break;
+        }
+    }
+    if (golden_path == NULL) {
+        printf("usage: %s [-machine name] [-journal file] [-dump prefix] [-record N,N,...]\n"
+               "          [-rewind frames] [-rewind-kb N] golden.txt\n", argv[0]);
+        return 1;
+    }
+
+    if (record) {
+        for (char *p = (char *) record; *p; ) {
+            AddGolden(strtoull(p, &p, 10), 0);
+            if (*p == ',')
+                p++;
+            else if (*p)
+                break;
+        }
+    } else {
+        LoadGolden(golden_path);
+    }
+    if (ngolden == 0) {
+        printf("error: no frames to check\n");
+        return 1;
+    }
+
+    State8080 *state = Init8080();
+    state->idle = IdleCreate();
+    DecodeCache *cache = DecodeCacheCreate();
+    Journal *journal = journal_path ? JournalLoad(journal_path) : JournalCreate();
+    Scheduler sched;
+    Video video;
+
+    SchedulerInit(&sched);
+    VideoInit(&video, machine, state, &sched);
+    MachineLoad(machine, state);
+    Rewind *rewind = rewind_interval ? RewindCreate(state, rewind_kb * 1024, rewind_interval) : NULL;
+
+    uint64_t frame = 0;
+    int next = 0, failed = 0;
+    uint64_t t0 = PacerNow();
+    JournalReplay(journal, state, 0);
+    if (rewind)
+        RewindFrame(rewind, 0, state, &sched, &video);
+    while (next < ngolden) {
+        if (!MachineRunFrame(state, cache, &sched, &video)) {
+            printf("error: CPU halted with interrupts disabled at $%04x, frame %llu\n",
+                   state->pc - 1, (unsigned long long) frame);
+            return 1;
+        }
+        frame++;
+
+        if (frame == golden[next].frame) {
+            if (record)
+                golden[next].hash = HashFrame(&machine->video, &state->memory[machine->video.base]);
+            else
+                failed |= CheckFrame(machine, state, &golden[next], dump, "");
+            next++;
+        }
+        JournalReplay(journal, state, frame);
+        if (rewind)
+            RewindFrame(rewind, frame, state, &sched, &video);
+    }
+    double ms = (PacerNow() - t0) / 1e6;
+
+    if (record) {
+        SaveGolden(golden_path, journal_path);
+        printf("recorded %d frames to %s\n", ngolden, golden_path);
+    } else {
+        printf("%s: %d frames checked, %s\n", golden_path, ngolden, failed ? "FAILED" : "ok");
+    }
+    printf("%llu frames in %.1f ms, %.1f frames/ms\n", (unsigned long long) frame, ms, frame / ms);
+
+    // Going back from the end to each golden frame in turn and replaying
+    // the journal forward must land on the same frame again
+    if (rewind && !record) {
+        RewindReport(rewind, stdout);
+        int checked = 0;
+        for (int i = ngolden - 1; i >= 0; i--) {
+            int64_t from = RewindTo(rewind, golden[i].frame - 1, state, &sched, &video);
+            if (from < 0)
+                break;
+            JournalSeek(journal, from);
+            for (frame = from; ; ) {
+                MachineRunFrame(state, cache, &sched, &video);
+                if (++frame == golden[i].frame)
+                    break;
+                JournalReplay(journal, state, frame);
+            }
+            failed |= CheckFrame(machine, state, &golden[i], dump, "rewind-");
+            checked++;
+        }
+        printf("rewind: %d of %d frames replayed from snapshots, %s\n", checked, ngolden,
+               failed ? "FAILED" : "ok");
+    }
+    return failed;
+}
@@ -0,0 +1,13 @@
+#include "frontend.h"
+
+// Headless runner: the SDL frontend's machine loop without a window. By
+// default it runs unthrottled, for capture, replays and benchmarking.
+
+int main(int argc, char **argv) {
+    Frontend fe;
+    FrontendParse(&fe, argc, argv, PACE_MAX, NULL);
+    FrontendInit(&fe);
+    FrontendRun(&fe);
+    FrontendClose(&fe);
+    return 0;
+}
@@ -0,0 +1,132 @@
+#include <stdlib.h>
+#include <string.h>
+#include "idle.h"
+#include "disasm.h"
+
+// JMP and the conditional jumps
+const uint8_t idle_jump[256] = {
+    [0xc2] = 1, [0xc3] = 1, [0xca] = 1, [0xd2] = 1,
+    [0xda] = 1, [0xe2] = 1, [0xea] = 1, [0xf2] = 1, [0xfa] = 1,
+};
+
+// Instructions that only read memory and change nothing but registers and
+// flags. A loop built from them cannot make progress by itself: if one
+// pass leaves the registers unchanged, every later pass does too until an
+// interrupt changes memory.
+static int IdleSafe(uint8_t op)
+{
+    if (op >= 0x40 && op <= 0x7f)           // MOV, except MOV M,r and HLT
+        return op < 0x70 || op > 0x77;
+    if (op >= 0x80 && op <= 0xbf)           // ALU with register or M
+        return 1;
+    switch (op) {
+        case 0x00:                          // NOP
+        case 0x0a: case 0x1a: case 0x3a:    // LDAX B, LDAX D, LDA
+        case 0x07: case 0x0f: case 0x17: case 0x1f:
+        case 0x2f: case 0x37: case 0x3f:    // CMA, STC, CMC
+        case 0x04: case 0x05: case 0x0c: case 0x0d:
+        case 0x14: case 0x15: case 0x1c: case 0x1d:
+        case 0x24: case 0x25: case 0x2c: case 0x2d:
+        case 0x3c: case 0x3d:               // INR/DCR r
+        case 0x06: case 0x0e: case 0x16: case 0x1e:
+        case 0x26: case 0x2e: case 0x3e:    // MVI r
+        case 0xc6: case 0xce: case 0xd6: case 0xde:
+        case 0xe6: case 0xee: case 0xf6: case 0xfe:     // ALU immediate
+            return 1;
+        default:
+            return idle_jump[op];
+    }
+}
+
+// Checks the body of the loop closed by the jump at `branch`. Jumps inside
+// the body must stay inside it, so the only way out is past `branch`.
+static int AnalyzeLoop(const State8080 *state, uint16_t branch)
+{
+    uint16_t head = MemRead(state, branch + 1) | MemRead(state, branch + 2) << 8;
+    if (head > branch || branch - head > IDLE_MAX_LOOP)
+        return IDLE_NEVER;
+    uint16_t pc = head;
+    while (pc < branch) {
+        Instr8080 ins;
+        uint8_t code[3] = {MemRead(state, pc), MemRead(state, pc + 1), MemRead(state, pc + 2)};
+        Decode8080(code, pc, &ins);
+        if (!IdleSafe(ins.opcode))
+            return IDLE_NEVER;
+        if (idle_jump[ins.opcode] && (Target8080(&ins) < head || Target8080(&ins) > branch))
+            return IDLE_NEVER;
+        pc += ins.length;
+    }
+    return pc == branch ? IDLE_CANDIDATE : IDLE_NEVER;
+}
+
+static void SaveRegs(const State8080 *state, uint8_t *regs)
+{
+    regs[0] = state->a;
+    regs[1] = state->b;
+    regs[2] = state->c;
+    regs[3] = state->d;
+    regs[4] = state->e;
+    regs[5] = state->h;
+    regs[6] = state->l;
+    regs[7] = state->cc.z | state->cc.s << 1 | state->cc.p << 2 | state->cc.cy << 3 | state->cc.ac << 4;
+    regs[8] = state->sp & 0xff;
+    regs[9] = state->sp >> 8;
+}
+
+IdleDetector *IdleCreate(void) {
+    return calloc(1, sizeof(IdleDetector));
+}
+
+// Called with state->pc on a jump. Two visits in a row with the same
+// registers make the loop a suspect; one pass is then run on a scratch
+// copy of the CPU to prove the registers come back unchanged. Nothing
+// but an interrupt can change the memory the loop reads, and none comes
+// before `until`, so all whole passes up to then are skipped.
+void IdleCheck(IdleDetector *idle, State8080 *state, uint64_t until) {
+    uint16_t branch = state->pc;
+    uint8_t *verdict = &idle->verdict[branch];
+    uint8_t regs[10];
+
+    if (*verdict == IDLE_UNKNOWN)
+        *verdict = AnalyzeLoop(state, branch);
+    if (*verdict != IDLE_CANDIDATE)
+        return;
+
+    SaveRegs(state, regs);
+    if (idle->last_branch != branch || memcmp(regs, idle->last_regs, sizeof(regs)) != 0) {
+        idle->last_branch = branch;
+        memcpy(idle->last_regs, regs, sizeof(regs));
+        return;
+    }
+
+    // The code may have changed since the verdict was cached
+    if (AnalyzeLoop(state, branch) != IDLE_CANDIDATE) {
+        *verdict = IDLE_NEVER;
+        return;
+    }
+
+    uint16_t head = MemRead(state, branch + 1) | MemRead(state, branch + 2) << 8;
+    State8080 scratch = *state;
+    scratch.idle = NULL;
+    for (int steps = 0; steps <= IDLE_MAX_LOOP; steps++) {
+        Emulate8080Op(&scratch);
+        if (scratch.pc == branch)
+            break;
+        if (scratch.pc < head || scratch.pc > branch)
+            return;     // the loop exits
+    }
+    uint8_t after[10];
+    SaveRegs(&scratch, after);
+    if (scratch.pc != branch || memcmp(regs, after, sizeof(regs)) != 0)
+        return;
+
+    uint64_t pass = scratch.cycles - state->cycles;
+    if (pass == 0 || state->cycles + pass >= until)
+        return;
+    // Stay short of `until` so the caller still runs the opcode that
+    // reaches it, as it would have without the skip
+    uint64_t skip = (until - state->cycles - 1) / pass * pass;
+    state->cycles += skip;
+    idle->skips++;
+    idle->skipped_cycles += skip;
+}
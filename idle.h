@@ -0,0 +1,39 @@
+#ifndef IDLE_H
+#define IDLE_H
+
+#include <stdint.h>
+#include "cpu8080.h"
+
+// Longest loop body, in bytes, that is considered for idle skipping
+#define IDLE_MAX_LOOP 32
+
+enum {
+    IDLE_UNKNOWN,
+    IDLE_CANDIDATE,     // body is free of side effects
+    IDLE_NEVER,
+};
+
+// Detects loops that spin on memory while waiting for an interrupt and
+// fast-forwards the cycle counter to the next scheduled event.
+typedef struct IdleDetector {
+    uint8_t verdict[0x10000];   // per backward-jump address
+    uint16_t last_branch;
+    uint8_t last_regs[10];
+    uint64_t skips;
+    uint64_t skipped_cycles;
+} IdleDetector;
+
+extern const uint8_t idle_jump[256];
+
+IdleDetector *IdleCreate(void);
+void IdleCheck(IdleDetector *idle, State8080 *state, uint64_t until);
+
+// Cheap test done by the run loops before every opcode: only jumps are
+// looked at any further.
+static inline void IdleOnOpcode(State8080 *state, uint64_t until)
+{
+    if (state->idle && idle_jump[MemRead(state, state->pc)])
+        IdleCheck(state->idle, state, until);
+}
+
+#endif
@@ -0,0 +1,83 @@
+#include "input.h"
+
+// Writes the buttons held into the port bits they are wired to
+static void Latch(Input *input)
+{
+    const Machine *machine = input->machine;
+    uint8_t *in = input->state->port.in;
+    for (int b = 0; b < NBUTTONS; b++) {
+        const PortBits *bits = &machine->button[b];
+        if (input->held >> b & 1)
+            in[bits->port] |= bits->mask;
+        else
+            in[bits->port] &= ~bits->mask;
+    }
+    input->frames++;
+    if (input->changed_ns && !input->latched_ns) {
+        input->latched_ns = input->changed_ns;
+        input->latched_frame = input->frames;
+    }
+    input->changed_ns = 0;
+}
+
+// Waits are relative to `now` rather than counted from a frame start kept
+// here, so a snapshot of the scheduler alone rewinds this device too
+static uint64_t InputRun(void *ctx, uint64_t now)
+{
+    Input *input = ctx;
+    CO_BEGIN(&input->co);
+    for (;;) {
+        if (input->poll)
+            input->poll(input, input->ctx);
+        Latch(input);
+        CO_WAIT_UNTIL(&input->co, now + CYCLES_PER_FRAME);
+    }
+    CO_END(&input->co);
+}
+
+// `poll` is called before every latch to update the buttons through
+// InputSet
+void InputInit(Input *input, const Machine *machine, State8080 *state, Scheduler *sched,
+               InputPoll poll, void *ctx) {
+    *input = (Input) {0};
+    input->machine = machine;
+    input->state = state;
+    input->poll = poll;
+    input->ctx = ctx;
+    input->sample_at = CYCLES_PER_FRAME - 1;
+    for (int i = 0; i < MAX_INTERRUPTS; i++) {
+        const Interrupt *irq = &machine->interrupt[i];
+        if (irq->rst && irq->end_frame)
+            input->sample_at = CYCLES_AT_LINE(irq->line) - 1;
+    }
+    SchedulerSpawn(sched, input->sample_at, InputRun, input);
+}
+
+// `when_ns` is the host time the change happened, on the PacerNow clock
+void InputSet(Input *input, uint32_t held, uint64_t when_ns) {
+    if (held == input->held)
+        return;
+    input->held = held;
+    if (!input->changed_ns)
+        input->changed_ns = when_ns;
+}
+
+// Called after presenting a frame that differs from the one before
+void InputPresented(Input *input, uint64_t now_ns) {
+    if (!input->latched_ns || input->frames <= input->latched_frame)
+        return;
+    uint64_t latency = now_ns > input->latched_ns ? now_ns - input->latched_ns : 0;
+    input->samples++;
+    input->total_ns += latency;
+    if (latency > input->max_ns)
+        input->max_ns = latency;
+    input->latched_ns = 0;
+}
+
+void InputReport(const Input *input, FILE *out) {
+    if (!input->samples)
+        return;
+    fprintf(out, "input to photon: %llu changes, mean %.1f ms, max %.1f ms\n",
+            (unsigned long long) input->samples, input->total_ns / 1e6 / input->samples,
+            input->max_ns / 1e6);
+}
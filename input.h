@@ -0,0 +1,48 @@
+#ifndef INPUT_H
+#define INPUT_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "cpu8080.h"
+#include "scheduler.h"
+#include "machine.h"
+
+// Live input, as a device coroutine. Once per frame, one cycle before the
+// vblank interrupt, it has the frontend poll its devices and then latches
+// the buttons held into the board's port bits, so the game sees input as
+// late as it can.
+//
+// It also measures input-to-photon latency: from the host time of a
+// change in the buttons held to the presentation of the first frame the
+// game drew after seeing it. The frame that ends at the vblank right
+// after the latch was drawn before, so it does not count.
+
+struct Input;
+typedef void (*InputPoll)(struct Input *input, void *ctx);
+
+typedef struct Input {
+    Coroutine co;
+    const Machine *machine;
+    State8080 *state;
+    InputPoll poll;
+    void *ctx;
+    uint64_t sample_at;     // cycles into a frame
+    uint64_t frames;        // latches so far
+
+    uint32_t held;          // a bit per Button
+    uint64_t changed_ns;    // oldest change not latched yet, 0 if none
+    uint64_t latched_ns;    // oldest change latched but not presented yet
+    uint64_t latched_frame;
+
+    uint64_t samples;
+    uint64_t total_ns;
+    uint64_t max_ns;
+} Input;
+
+void InputInit(Input *input, const Machine *machine, State8080 *state, Scheduler *sched,
+               InputPoll poll, void *ctx);
+void InputSet(Input *input, uint32_t held, uint64_t when_ns);
+void InputPresented(Input *input, uint64_t now_ns);
+void InputReport(const Input *input, FILE *out);
+
+#endif
@@ -0,0 +1,78 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "journal.h"
+
+Journal *JournalCreate(void) {
+    return calloc(1, sizeof(Journal));
+}
+
+Journal *JournalLoad(const char *path) {
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        printf("error: Couldn't open %s\n", path);
+        exit(1);
+    }
+    Journal *journal = JournalCreate();
+    char line[256];
+    int lineno = 0;
+    while (fgets(line, sizeof(line), f)) {
+        unsigned frame, port, value;
+        char extra;
+        lineno++;
+        if (line[0] == '#' || sscanf(line, " %c", &extra) != 1)
+            continue;
+        if (sscanf(line, "%u %u %x", &frame, &port, &value) != 3 || value > 0xff) {
+            printf("error: %s:%d: expected \"frame port value\"\n", path, lineno);
+            exit(1);
+        }
+        JournalAdd(journal, frame, port, value);
+    }
+    fclose(f);
+    return journal;
+}
+
+void JournalSave(const Journal *journal, const char *path) {
+    FILE *f = fopen(path, "w");
+    if (f == NULL) {
+        printf("error: Couldn't open %s\n", path);
+        exit(1);
+    }
+    fprintf(f, "# frame port value\n");
+    for (int i = 0; i < journal->count; i++)
+        fprintf(f, "%u %u %02x\n", journal->entry[i].frame, journal->entry[i].port, journal->entry[i].value);
+    fclose(f);
+}
+
+// Entries must be added in frame order
+void JournalAdd(Journal *journal, uint32_t frame, uint8_t port, uint8_t value) {
+    if (journal->count > 0 && frame < journal->entry[journal->count - 1].frame) {
+        printf("error: journal entry for frame %u is out of order\n", frame);
+        exit(1);
+    }
+    if (journal->count == journal->capacity) {
+        journal->capacity = journal->capacity ? journal->capacity * 2 : 64;
+        journal->entry = realloc(journal->entry, journal->capacity * sizeof(JournalEntry));
+    }
+    journal->entry[journal->count++] = (JournalEntry) {frame, port, value};
+}
+
+// Applies every entry up to and including `frame` to the input ports
+void JournalReplay(Journal *journal, State8080 *state, uint64_t frame) {
+    while (journal->next < journal->count && journal->entry[journal->next].frame <= frame) {
+        const JournalEntry *e = &journal->entry[journal->next++];
+        state->port.in[e->port % IO_PORTS] = e->value;
+    }
+}
+
+// Positions replay after the entries up to and including `frame`, whose
+// effect a restored snapshot already holds
+void JournalSeek(Journal *journal, uint64_t frame) {
+    journal->next = 0;
+    while (journal->next < journal->count && journal->entry[journal->next].frame <= frame)
+        journal->next++;
+}
+
+void JournalFree(Journal *journal) {
+    free(journal->entry);
+    free(journal);
+}
@@ -0,0 +1,34 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <stdint.h>
+#include "cpu8080.h"
+
+// Input journal: the values written to the input ports and the frame each
+// took effect on. Replaying one makes a run repeatable.
+//
+// On disk it is text, one "frame port value" line per entry with the
+// value in hex. Lines starting with # are comments.
+
+typedef struct JournalEntry {
+    uint32_t frame;
+    uint8_t port;
+    uint8_t value;
+} JournalEntry;
+
+typedef struct Journal {
+    JournalEntry *entry;
+    int count;
+    int capacity;
+    int next;               // replay position
+} Journal;
+
+Journal *JournalCreate(void);
+Journal *JournalLoad(const char *path);
+void JournalSave(const Journal *journal, const char *path);
+void JournalAdd(Journal *journal, uint32_t frame, uint8_t port, uint8_t value);
+void JournalReplay(Journal *journal, State8080 *state, uint64_t frame);
+void JournalSeek(Journal *journal, uint64_t frame);
+void JournalFree(Journal *journal);
+
+#endif
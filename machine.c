@@ -0,0 +1,230 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "machine.h"
+#include "counters.h"
+
+// Ports decode only the low three address lines
+uint8_t MachineIN(const Machine *machine, State8080* state, uint8_t port)
+{
+    port %= IO_PORTS;
+    switch(machine->in[port])
+    {
+        case IO_INPUT:
+            return state->port.in[port];
+        case IO_SHIFT_RESULT:
+            return (state->port.shift >> (8 - state->port.shift_amount)) & 0xff;
+        default:
+            return 0;
+    }
+}
+
+void MachineOUT(const Machine *machine, State8080* state, uint8_t port, uint8_t value)
+{
+    switch(machine->out[port % IO_PORTS])
+    {
+        case IO_SHIFT_AMOUNT:
+            state->port.shift_amount = value & 0x7;
+            break;
+        case IO_SHIFT_DATA:
+            state->port.shift = value << 8 | state->port.shift >> 8;
+            break;
+    }
+}
+
+static uint8_t BoardIn(State8080 *state, uint8_t port)
+{
+    if (state->counters)
+        COUNT(state->counters->port_in[port % IO_PORTS], 1);
+    return MachineIN(state->board, state, port);
+}
+
+static void BoardOut(State8080 *state, uint8_t port, uint8_t value)
+{
+    if (state->counters)
+        COUNT(state->counters->port_out[port % IO_PORTS], 1);
+    MachineOUT(state->board, state, port, value);
+}
+
+static uint64_t VideoRun(void *ctx, uint64_t now)
+{
+    Video *video = ctx;
+    (void) now;
+    CO_BEGIN(&video->co);
+    for (;; video->frame_start += CYCLES_PER_FRAME) {
+        for (video->next = 0; video->next < MAX_INTERRUPTS; video->next++) {
+            const Interrupt *irq = &video->machine->interrupt[video->next];
+            if (!irq->rst)
+                break;
+            CO_WAIT_UNTIL(&video->co, video->frame_start + CYCLES_AT_LINE(irq->line));
+            irq = &video->machine->interrupt[video->next];
+            GenerateInterrupt(video->state, irq->rst);
+            if (irq->end_frame)
+                video->frame_done = 1;
+        }
+    }
+    CO_END(&video->co);
+}
+
+void VideoInit(Video *video, const Machine *machine, State8080 *state, Scheduler *sched) {
+    video->co.line = 0;
+    video->machine = machine;
+    video->state = state;
+    video->frame_start = 0;
+    video->next = 0;
+    video->frame_done = 0;
+    SchedulerSpawn(sched, 0, VideoRun, video);
+}
+
+// Runs to the end of the next frame, on the fused core or, without a
+// decode cache, the slice core. Returns 0 if the CPU has stopped for good
+// instead.
+int MachineRunFrame(State8080 *state, DecodeCache *cache, Scheduler *sched, Video *video) {
+    while (!video->frame_done) {
+        if (cache)
+            Run8080Fused(state, cache, SchedulerNext(sched));
+        else
+            Run8080Slice(state, SchedulerNext(sched));
+        SchedulerRunDue(sched, state->cycles);
+        if (state->halted && !state->int_enable)
+            return 0;
+    }
+    video->frame_done = 0;
+    return 1;
+}
+
+// The boards below share the Space Invaders ports: inputs on 0-2, the
+// shift register on 2-4, and sound and the watchdog on 3, 5 and 6, which
+// are not emulated.
+#define INVADERS_IO \
+    .in = {IO_INPUT, IO_INPUT, IO_INPUT, IO_SHIFT_RESULT}, \
+    .out = {[2] = IO_SHIFT_AMOUNT, [4] = IO_SHIFT_DATA}, \
+    .in_default = {0x0e, 0x08, 0x00}, \
+    .button = { \
+        [BUTTON_COIN] = {1, 0x01}, [BUTTON_START2] = {1, 0x02}, [BUTTON_START1] = {1, 0x04}, \
+        [BUTTON_FIRE1] = {1, 0x10}, [BUTTON_LEFT1] = {1, 0x20}, [BUTTON_RIGHT1] = {1, 0x40}, \
+        [BUTTON_TILT] = {2, 0x04}, \
+        [BUTTON_FIRE2] = {2, 0x10}, [BUTTON_LEFT2] = {2, 0x20}, [BUTTON_RIGHT2] = {2, 0x40}, \
+    }, \
+    .interrupt = {{MIDSCREEN_LINE, 1, 0}, {VBLANK_LINE, 2, 1}}, \
+    .video = {0x2400, 256, 224}
+
+#define ROM_8K(a, b, c, d) {a, 0x0000}, {b, 0x0800}, {c, 0x1000}, {d, 0x1800}
+
+const Machine machines[] = {
+    {
+        .name = "invaders",
+        .title = "Space Invaders",
+        .rom = {ROM_8K("invaders.h", "invaders.g", "invaders.f", "invaders.e")},
+        // A14 and A15 are not decoded, so ROM and RAM repeat every 16K
+        .region = {
+            {0x0000, 0x2000, 0x0000, 0}, {0x2000, 0x2000, 0x2000, 1},
+            {0x4000, 0x2000, 0x0000, 0}, {0x6000, 0x2000, 0x2000, 1},
+            {0x8000, 0x2000, 0x0000, 0}, {0xa000, 0x2000, 0x2000, 1},
+            {0xc000, 0x2000, 0x0000, 0}, {0xe000, 0x2000, 0x2000, 1},
+        },
+        INVADERS_IO,
+        .dip = {
+            {"ships", {2, 0x03}, "0-3 for 3-6 ships"},
+            {"bonus", {2, 0x08}, "0 for an extra ship at 1500, 1 at 1000"},
+            {"coininfo", {2, 0x80}, "0 to show the coin info in the demo, 1 not"},
+        },
+        .game = {.score = 0x20f8, .score_bytes = 2, .playing = 0x20ef},
+    },
+    {
+        .name = "lrescue",
+        .title = "Lunar Rescue",
+        .rom = {ROM_8K("lrescue.1", "lrescue.2", "lrescue.3", "lrescue.4"),
+                {"lrescue.5", 0x4000}, {"lrescue.6", 0x4800}},
+        .region = {
+            {0x0000, 0x2000, 0x0000, 0}, {0x2000, 0x2000, 0x2000, 1},
+            {0x4000, 0x2000, 0x4000, 0},
+        },
+        INVADERS_IO,
+    },
+    {
+        .name = "ballbomb",
+        .title = "Balloon Bomber",
+        .rom = {ROM_8K("tn01", "tn02", "tn03", "tn04"), {"tn05-1", 0x4000}},
+        .region = {
+            {0x0000, 0x2000, 0x0000, 0}, {0x2000, 0x2000, 0x2000, 1},
+            {0x4000, 0x0800, 0x4000, 0},
+        },
+        INVADERS_IO,
+    },
+};
+
+const int nmachines = sizeof(machines) / sizeof(machines[0]);
+
+const Machine *MachineFind(const char *name)
+{
+    for (int i = 0; i < nmachines; i++)
+        if (strcmp(machines[i].name, name) == 0)
+            return &machines[i];
+    printf("error: unknown machine %s; known machines are:\n", name);
+    for (int i = 0; i < nmachines; i++)
+        printf("  %-10s %s\n", machines[i].name, machines[i].title);
+    exit(1);
+}
+
+// Loads the ROMs from the working directory and sets up the memory map,
+// the ports and the input levels
+void MachineLoad(const Machine *machine, State8080 *state) {
+    for (int i = 0; i < MAX_ROMS && machine->rom[i].file; i++)
+        ReadFileIntoMemoryAt(state, (char *) machine->rom[i].file, machine->rom[i].address);
+
+    MemoryMapFlat(state->map);
+    for (int i = 0; i < MAX_REGIONS && machine->region[i].size; i++) {
+        const MemoryRegion *r = &machine->region[i];
+        MemoryMapRange(state->map, r->start, r->size, r->target, r->writable);
+    }
+    memcpy(state->port.in, machine->in_default, sizeof(state->port.in));
+    state->board = machine;
+    state->port_in = BoardIn;
+    state->port_out = BoardOut;
+}
+
+// name=value, with value shifted into the switch's bits. Call after
+// MachineLoad.
+void MachineSetDip(const Machine *machine, State8080 *state, const char *arg)
+{
+    const char *eq = strchr(arg, '=');
+    for (int i = 0; eq && i < MAX_DIPS && machine->dip[i].name; i++) {
+        const DipSwitch *dip = &machine->dip[i];
+        if (strlen(dip->name) != (size_t) (eq - arg) || strncmp(dip->name, arg, eq - arg) != 0)
+            continue;
+        uint8_t mask = dip->bits.mask;
+        unsigned value = strtoul(eq + 1, NULL, 0);
+        uint8_t shifted = value << __builtin_ctz(mask);
+        if ((shifted & mask) >> __builtin_ctz(mask) != value) {
+            printf("error: %s takes %s\n", dip->name, dip->values);
+            exit(1);
+        }
+        state->port.in[dip->bits.port] = (state->port.in[dip->bits.port] & ~mask) | shifted;
+        return;
+    }
+    printf("error: %s has no DIP switch %s; it has:\n", machine->name, arg);
+    for (int i = 0; i < MAX_DIPS && machine->dip[i].name; i++)
+        printf("  %-10s %s\n", machine->dip[i].name, machine->dip[i].values);
+    exit(1);
+}
+
+// Writes the frame buffer as a binary PBM. PBM packs pixels MSB first
+// with 1 meaning black, so each byte is bit reversed and inverted.
+void WriteFramePBM(const char *path, const VideoFormat *video, const uint8_t *vram)
+{
+    FILE *f = fopen(path, "wb");
+    if (f == NULL) {
+        printf("error: Couldn't open %s\n", path);
+        exit(1);
+    }
+    fprintf(f, "P4\n%d %d\n", video->width, video->height);
+    for (uint32_t i = 0; i < VideoBytes(video); i++) {
+        uint8_t b = vram[i];
+        b = (b & 0xf0) >> 4 | (b & 0x0f) << 4;
+        b = (b & 0xcc) >> 2 | (b & 0x33) << 2;
+        b = (b & 0xaa) >> 1 | (b & 0x55) << 1;
+        fputc(~b & 0xff, f);
+    }
+    fclose(f);
+}
@@ -0,0 +1,143 @@
+#ifndef MACHINE_H
+#define MACHINE_H
+
+#include <stdint.h>
+#include "cpu8080.h"
+#include "scheduler.h"
+#include "fused.h"
+
+// Timing shared by the Space Invaders family of boards: a 2 MHz 8080 and
+// a 60 Hz display with 262 lines per frame. The hardware raises RST 1
+// when the beam reaches line 96 and RST 2 when it enters vblank at line
+// 224.
+#define CPU_HZ 2000000
+#define FRAMES_PER_SECOND 60
+#define CYCLES_PER_FRAME (CPU_HZ / FRAMES_PER_SECOND)
+#define LINES_PER_FRAME 262
+#define MIDSCREEN_LINE 96
+#define VBLANK_LINE 224
+#define CYCLES_AT_LINE(line) ((uint64_t)(line) * CYCLES_PER_FRAME / LINES_PER_FRAME)
+
+#define MAX_ROMS 8
+#define MAX_REGIONS 8
+#define MAX_INTERRUPTS 2
+#define MAX_DIPS 4
+
+// A board described as data. MachineLoad compiles it into the memory map
+// and port tables once, so the cores and the renderer never look at it
+// while running.
+
+typedef struct RomFile {
+    const char *file;
+    uint16_t address;
+} RomFile;
+
+// `size` bytes from `start` map to `target` in the backing memory.
+// Unlisted pages are plain RAM.
+typedef struct MemoryRegion {
+    uint32_t start;
+    uint32_t size;
+    uint32_t target;
+    int writable;
+} MemoryRegion;
+
+typedef enum IoDevice {
+    IO_NONE,            // reads 0, writes are dropped
+    IO_INPUT,           // the level in state->port.in
+    IO_SHIFT_RESULT,
+    IO_SHIFT_AMOUNT,
+    IO_SHIFT_DATA,
+} IoDevice;
+
+// Cabinet controls, wired to input port bits by each board
+typedef enum Button {
+    BUTTON_COIN,
+    BUTTON_START1,
+    BUTTON_START2,
+    BUTTON_FIRE1,
+    BUTTON_LEFT1,
+    BUTTON_RIGHT1,
+    BUTTON_FIRE2,
+    BUTTON_LEFT2,
+    BUTTON_RIGHT2,
+    BUTTON_TILT,
+    NBUTTONS,
+} Button;
+
+// Bits of an input port; a zero mask is not wired
+typedef struct PortBits {
+    uint8_t port;
+    uint8_t mask;
+} PortBits;
+
+typedef struct DipSwitch {
+    const char *name;
+    PortBits bits;
+    const char *values;     // what the settings mean, for the user
+} DipSwitch;
+
+typedef struct Interrupt {
+    uint16_t line;
+    uint8_t rst;
+    uint8_t end_frame;  // the frame is complete once this one fires
+} Interrupt;
+
+// A 1 bit per pixel frame buffer, LSB first
+typedef struct VideoFormat {
+    uint16_t base;
+    uint16_t width;
+    uint16_t height;
+} VideoFormat;
+
+// Where the game keeps its state in RAM, for the RL environment. The
+// score is BCD, least significant byte first. Zero when not known.
+typedef struct GameRam {
+    uint16_t score;
+    uint8_t score_bytes;
+    uint16_t playing;   // nonzero while a game is in progress
+} GameRam;
+
+typedef struct Machine {
+    const char *name;
+    const char *title;
+    RomFile rom[MAX_ROMS];
+    MemoryRegion region[MAX_REGIONS];
+    uint8_t in[IO_PORTS];       // IoDevice for each port
+    uint8_t out[IO_PORTS];
+    uint8_t in_default[IO_PORTS];
+    PortBits button[NBUTTONS];
+    DipSwitch dip[MAX_DIPS];
+    Interrupt interrupt[MAX_INTERRUPTS];
+    VideoFormat video;
+    GameRam game;
+} Machine;
+
+static inline uint32_t VideoBytes(const VideoFormat *video)
+{
+    return (uint32_t) video->width * video->height / 8;
+}
+
+// The beam, as a device coroutine: raises the machine's interrupts at
+// their scanlines and flags the frame once the beam enters vblank.
+typedef struct Video {
+    Coroutine co;
+    const Machine *machine;
+    State8080 *state;
+    uint64_t frame_start;   // cycle the current frame began at
+    int next;               // the interrupt the beam is heading for
+    int frame_done;
+} Video;
+
+extern const Machine machines[];
+extern const int nmachines;
+
+const Machine *MachineFind(const char *name);
+void MachineLoad(const Machine *machine, State8080 *state);
+void MachineSetDip(const Machine *machine, State8080 *state, const char *arg);
+void VideoInit(Video *video, const Machine *machine, State8080 *state, Scheduler *sched);
+int MachineRunFrame(State8080 *state, DecodeCache *cache, Scheduler *sched, Video *video);
+uint8_t MachineIN(const Machine *machine, State8080 *state, uint8_t port);
+void MachineOUT(const Machine *machine, State8080 *state, uint8_t port, uint8_t value);
+void WriteFramePBM(const char *path, const VideoFormat *video, const uint8_t *vram);
+
+#endif
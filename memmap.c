@@ -0,0 +1,28 @@
+#include <string.h>
+#include "memmap.h"
+
+// 64K of RAM
+void MemoryMapFlat(MemoryMap *map) {
+    MemoryMapRange(map, 0, MEMORY_SIZE, 0, 1);
+    memset(map->dirty, DIRTY_ALL, sizeof(map->dirty));
+}
+
+// Maps [start, start + size) onto the backing array at `target`. All
+// three must be multiples of the page size.
+void MemoryMapRange(MemoryMap *map, uint32_t start, uint32_t size, uint32_t target, int writable) {
+    for (uint32_t page = 0; page < size >> 8; page++) {
+        map->read[(start >> 8) + page] = target + (page << 8);
+        map->write[(start >> 8) + page] = writable ? target + (page << 8) : MEMORY_SINK;
+    }
+}
+
+// Returns whether any backing page of [start, start + size) was written
+// since `bit` was last cleared there, and clears it
+int MemoryTakeDirty(MemoryMap *map, uint32_t start, uint32_t size, uint8_t bit) {
+    uint8_t any = 0;
+    for (uint32_t page = start >> 8; page < (start + size + 0xff) >> 8; page++) {
+        any |= map->dirty[page];
+        map->dirty[page] &= ~bit;
+    }
+    return (any & bit) != 0;
+}
@@ -0,0 +1,59 @@
+#ifndef MEMMAP_H
+#define MEMMAP_H
+
+#include <stdint.h>
+
+// The address space in 256-byte pages. Each page maps to an offset in
+// the backing array, separately for reads and writes, which covers both
+// mirroring and ROM: ROM pages send their writes to a sink page past the
+// end of memory. Every write also sets all the dirty bits of the backing
+// page it lands in; each consumer owns one bit and clears it once it has
+// caught up. Accesses are two table lookups and no branches.
+
+#define MEMORY_SIZE 0x10000
+#define MEMORY_SINK MEMORY_SIZE
+#define MEMORY_ALLOC (MEMORY_SIZE + 0x100)
+
+enum {
+    DIRTY_VIDEO = 0x01,
+    DIRTY_CODE = 0x02,
+    DIRTY_ALL = 0xff,
+};
+
+typedef struct MemoryMap {
+    uint32_t read[256];
+    uint32_t write[256];
+    uint8_t dirty[257];     // by backing page; the last one is the sink
+} MemoryMap;
+
+void MemoryMapFlat(MemoryMap *map);
+void MemoryMapRange(MemoryMap *map, uint32_t start, uint32_t size, uint32_t target, int writable);
+int MemoryTakeDirty(MemoryMap *map, uint32_t start, uint32_t size, uint8_t bit);
+
+static inline uint8_t MapRead(const uint8_t *memory, const MemoryMap *map, uint16_t addr)
+{
+    return memory[map->read[addr >> 8] | (addr & 0xff)];
+}
+
+// The instruction at addr. Its operands may be on the next page, which
+// can be mapped anywhere, or wrap past 0xffff; near the end of a page they
+// are read through the map into `buf`.
+static inline const uint8_t *MapFetch(const uint8_t *memory, const MemoryMap *map, uint16_t addr, uint8_t *buf)
+{
+    if ((addr & 0xff) > 0xfd) {
+        buf[0] = MapRead(memory, map, addr);
+        buf[1] = MapRead(memory, map, addr + 1);
+        buf[2] = MapRead(memory, map, addr + 2);
+        return buf;
+    }
+    return &memory[map->read[addr >> 8] | (addr & 0xff)];
+}
+
+static inline void MapWrite(uint8_t *memory, MemoryMap *map, uint16_t addr, uint8_t value)
+{
+    uint32_t offset = map->write[addr >> 8] | (addr & 0xff);
+    memory[offset] = value;
+    map->dirty[offset >> 8] = DIRTY_ALL;
+}
+
+#endif
@@ -0,0 +1,66 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include "metrics.h"
+#include "net.h"
+#include "counters.h"
+
+// One request per connection; the request itself is read and ignored
+static void Answer(int fd)
+{
+    char request[1024];
+    recv(fd, request, sizeof(request), 0);
+
+    char *body;
+    size_t body_size;
+    FILE *out = open_memstream(&body, &body_size);
+    CountersWrite(out);
+    fclose(out);
+
+    char header[128];
+    int header_size = snprintf(header, sizeof(header),
+                               "HTTP/1.0 200 OK\r\n"
+                               "Content-Type: text/plain; version=0.0.4\r\n"
+                               "Content-Length: %zu\r\n\r\n", body_size);
+    // A client that hangs up early must not take the emulator with it
+    if (send(fd, header, header_size, MSG_NOSIGNAL) == header_size)
+        send(fd, body, body_size, MSG_NOSIGNAL);
+    free(body);
+}
+
+static void *Serve(void *arg)
+{
+    int listen_fd = (int) (intptr_t) arg;
+    for (;;) {
+        int fd = accept(listen_fd, NULL, NULL);
+        if (fd < 0)
+            continue;
+        Answer(fd);
+        close(fd);
+    }
+    return NULL;
+}
+
+static void WriteAtExit(void)
+{
+    CountersWrite(stdout);
+}
+
+void MetricsServe(const char *address) {
+    if (strcmp(address, "-") == 0) {
+        atexit(WriteAtExit);
+        return;
+    }
+    pthread_t thread;
+    int fd = ListenOn(address, 4);
+    if (pthread_create(&thread, NULL, Serve, (void *) (intptr_t) fd) != 0) {
+        printf("error: Couldn't start the metrics thread\n");
+        exit(1);
+    }
+    pthread_detach(thread);
+    printf("serving metrics on %s\n", address);
+}
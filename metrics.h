@@ -0,0 +1,10 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+// Serves the performance counters in the Prometheus text format, over
+// HTTP on a local TCP port or a Unix socket, from a thread of its own.
+// Every request gets the same answer, so any path works as /metrics.
+// "-" instead writes them to stdout when the program exits.
+void MetricsServe(const char *address);
+
+#endif
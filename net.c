@@ -0,0 +1,42 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "net.h"
+
+int ListenOn(const char *address, int backlog) {
+    int fd;
+    if (strchr(address, '/')) {
+        struct sockaddr_un sun;
+        memset(&sun, 0, sizeof(sun));
+        sun.sun_family = AF_UNIX;
+        strncpy(sun.sun_path, address, sizeof(sun.sun_path) - 1);
+        unlink(address);
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0 || bind(fd, (struct sockaddr *) &sun, sizeof(sun)) < 0) {
+            printf("error: Couldn't bind %s\n", address);
+            exit(1);
+        }
+    } else {
+        struct sockaddr_in sin;
+        const char *colon = strrchr(address, ':');
+        memset(&sin, 0, sizeof(sin));
+        sin.sin_family = AF_INET;
+        sin.sin_port = htons(atoi(colon ? colon + 1 : address));
+        sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        int one = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        if (fd < 0 || bind(fd, (struct sockaddr *) &sin, sizeof(sin)) < 0) {
+            printf("error: Couldn't bind %s\n", address);
+            exit(1);
+        }
+    }
+    listen(fd, backlog);
+    return fd;
+}
@@ -0,0 +1,10 @@
+#ifndef NET_H
+#define NET_H
+
+// Binds and listens on "host:port", ":port" or, for anything with a '/',
+// a Unix socket path, replacing a stale socket file. TCP ports are on
+// the loopback interface only. Returns the listening socket; exits on
+// failure.
+int ListenOn(const char *address, int backlog);
+
+#endif
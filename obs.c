@@ -0,0 +1,215 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "obs.h"
+
+#if defined(__SSE2__) && !defined(OBS_SCALAR)
+#include <emmintrin.h>
+#define OBS_SSE2
+#endif
+
+// packed | rotated | [rotated-]gray:WxH. Leaves the stack alone.
+int ObsParse(const char *arg, ObsFormat *format) {
+    format->rotate = 0;
+    format->gray = 0;
+    if (strncmp(arg, "rotated", 7) == 0) {
+        format->rotate = 1;
+        arg += 7;
+        if (*arg == '\0')
+            return 0;
+        if (*arg++ != '-')
+            return -1;
+    } else if (strcmp(arg, "packed") == 0) {
+        return 0;
+    }
+    unsigned width, height;
+    char end;
+    if (sscanf(arg, "gray:%ux%u%c", &width, &height, &end) != 2 || width == 0 || height == 0)
+        return -1;
+    format->gray = 1;
+    format->width = width;
+    format->height = height;
+    return 0;
+}
+
+// The picture the exporters start from, before any downsampling
+static void SourceSize(const ObsFormat *format, const VideoFormat *video, int *width, int *height)
+{
+    *width = format->rotate ? video->height : video->width;
+    *height = format->rotate ? video->width : video->height;
+}
+
+size_t ObsFrameBytes(const ObsFormat *format, const VideoFormat *video) {
+    if (format->gray)
+        return (size_t) format->width * format->height;
+    return VideoBytes(video);
+}
+
+// Turns the frame a quarter turn anticlockwise: stored column x becomes
+// upright row width-1-x, stored row y upright column y. With SSE2 the
+// same byte of 16 stored rows is gathered into a vector; its top bits,
+// one movemask at a time, are 16 upright pixels in a row.
+static void Rotate(const VideoFormat *video, const uint8_t *vram, uint8_t *out, int simd)
+{
+    int row_bytes = video->width / 8;
+    int out_bytes = video->height / 8;
+    int y = 0;
+#ifdef OBS_SSE2
+    for (; simd && y + 16 <= video->height; y += 16) {
+        const uint8_t *p = &vram[y * row_bytes];
+        for (int bx = 0; bx < row_bytes; bx++) {
+            __m128i v = _mm_setr_epi8(
+                p[bx], p[row_bytes + bx], p[2 * row_bytes + bx], p[3 * row_bytes + bx],
+                p[4 * row_bytes + bx], p[5 * row_bytes + bx], p[6 * row_bytes + bx],
+                p[7 * row_bytes + bx], p[8 * row_bytes + bx], p[9 * row_bytes + bx],
+                p[10 * row_bytes + bx], p[11 * row_bytes + bx], p[12 * row_bytes + bx],
+                p[13 * row_bytes + bx], p[14 * row_bytes + bx], p[15 * row_bytes + bx]);
+            for (int bit = 7; bit >= 0; bit--) {
+                uint16_t mask = _mm_movemask_epi8(v);
+                uint8_t *o = &out[(video->width - 1 - (bx * 8 + bit)) * out_bytes + y / 8];
+                o[0] = mask;
+                o[1] = mask >> 8;
+                v = _mm_add_epi8(v, v);
+            }
+        }
+    }
+#else
+    (void) simd;
+#endif
+    for (; y < video->height; y++) {
+        for (int x = 0; x < video->width; x++) {
+            uint8_t *o = &out[(video->width - 1 - x) * out_bytes + y / 8];
+            if (y % 8 == 0)
+                *o = 0;
+            *o |= (vram[y * row_bytes + x / 8] >> (x & 7) & 1) << (y & 7);
+        }
+    }
+}
+
+// Adds each pixel of a packed row into its byte counter
+static void CountRow(const uint8_t *row, int width, uint8_t *count, int simd)
+{
+    int x = 0;
+#ifdef OBS_SSE2
+    // Lane i tests bit i % 8 of its byte, and a lit pixel's -1 is subtracted
+    const __m128i bits = _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128);
+    for (; simd && x + 16 <= width; x += 16) {
+        __m128i v = _mm_set_epi64x(row[x / 8 + 1] * 0x0101010101010101ull,
+                                   row[x / 8] * 0x0101010101010101ull);
+        __m128i lit = _mm_cmpeq_epi8(_mm_and_si128(v, bits), bits);
+        __m128i *c = (__m128i *) &count[x];
+        _mm_storeu_si128(c, _mm_sub_epi8(_mm_loadu_si128(c), lit));
+    }
+#else
+    (void) simd;
+#endif
+    for (; x < width; x++)
+        count[x] += row[x / 8] >> (x & 7) & 1;
+}
+
+// Box filter: each output pixel is the share of lit pixels in its box of
+// the source. Rows of a box are counted per column, then the columns of
+// each box summed.
+static void Downsample(const ObsFormat *format, int width, int height, const uint8_t *src, uint8_t *out,
+                       int simd)
+{
+    int row_bytes = width / 8;
+    uint8_t count[256];
+    for (int oy = 0; oy < format->height; oy++) {
+        int y0 = oy * height / format->height;
+        int y1 = (oy + 1) * height / format->height;
+        memset(count, 0, width);
+        for (int y = y0; y < y1; y++)
+            CountRow(&src[y * row_bytes], width, count, simd);
+        for (int ox = 0; ox < format->width; ox++) {
+            int x0 = ox * width / format->width;
+            int x1 = (ox + 1) * width / format->width;
+            unsigned lit = 0;
+            for (int x = x0; x < x1; x++)
+                lit += count[x];
+            unsigned area = (x1 - x0) * (y1 - y0);
+            *out++ = (lit * 255 + area / 2) / area;
+        }
+    }
+}
+
+static void Export(const ObsFormat *format, const VideoFormat *video, const uint8_t *vram, uint8_t *out,
+                   int simd)
+{
+    uint8_t rotated[OBS_MAX_BYTES];
+    if (!format->gray) {
+        if (format->rotate)
+            Rotate(video, vram, out, simd);
+        else
+            memcpy(out, vram, VideoBytes(video));
+        return;
+    }
+    int width, height;
+    SourceSize(format, video, &width, &height);
+    if (format->rotate) {
+        Rotate(video, vram, rotated, simd);
+        vram = rotated;
+    }
+    Downsample(format, width, height, vram, out, simd);
+}
+
+// One frame in `format`; `out` takes ObsFrameBytes
+void ObsExport(const ObsFormat *format, const VideoFormat *video, const uint8_t *vram, uint8_t *out) {
+    Export(format, video, vram, out, 1);
+}
+
+// The same without SIMD, which obscheck compares ObsExport against
+void ObsExportScalar(const ObsFormat *format, const VideoFormat *video, const uint8_t *vram, uint8_t *out) {
+    Export(format, video, vram, out, 0);
+}
+
+// Checks the format against the frame buffer, since the exporters do not
+ObsStack *ObsStackCreate(const ObsFormat *format, const VideoFormat *video) {
+    int width, height;
+    SourceSize(format, video, &width, &height);
+    if (video->width > 256 || video->height > 256 || video->width % 8 || video->height % 8) {
+        printf("error: can't export a %dx%d frame buffer\n", video->width, video->height);
+        exit(1);
+    }
+    if (format->gray && (format->width > width || format->height > height ||
+                         (height + format->height - 1) / format->height > 255)) {
+        printf("error: can't downsample %dx%d to %dx%d\n", width, height,
+               format->width, format->height);
+        exit(1);
+    }
+
+    ObsStack *stack = calloc(1, sizeof(ObsStack));
+    stack->format = *format;
+    if (stack->format.stack < 1)
+        stack->format.stack = 1;
+    stack->video = *video;
+    stack->frame_bytes = ObsFrameBytes(format, video);
+    stack->frames = malloc(stack->frame_bytes * stack->format.stack);
+    return stack;
+}
+
+// Starts over with every slot holding this frame, as after a reset
+void ObsStackFill(ObsStack *stack, const uint8_t *vram) {
+    ObsExport(&stack->format, &stack->video, vram, stack->frames);
+    for (int i = 1; i < stack->format.stack; i++)
+        memcpy(stack->frames + i * stack->frame_bytes, stack->frames, stack->frame_bytes);
+    stack->head = 0;
+}
+
+// Replaces the oldest frame
+void ObsStackPush(ObsStack *stack, const uint8_t *vram) {
+    ObsExport(&stack->format, &stack->video, vram, stack->frames + stack->head * stack->frame_bytes);
+    stack->head = (stack->head + 1) % stack->format.stack;
+}
+
+// The stack as one tensor, oldest frame first
+void ObsStackWrite(const ObsStack *stack, uint8_t *out) {
+    size_t older = (stack->format.stack - stack->head) * stack->frame_bytes;
+    memcpy(out, stack->frames + stack->head * stack->frame_bytes, older);
+    memcpy(out + older, stack->frames, stack->head * stack->frame_bytes);
+}
+
+void ObsStackFree(ObsStack *stack) {
+    free(stack->frames);
+    free(stack);
+}
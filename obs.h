@@ -0,0 +1,48 @@
+#ifndef OBS_H
+#define OBS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "machine.h"
+
+// Observations for ML, computed straight from the 1 bpp frame buffer:
+//
+//   packed             the frame buffer as is, LSB first
+//   rotated            upright as the cabinet shows it, packed LSB first
+//   gray:WxH           8-bit grayscale box-filtered down to W x H
+//   rotated-gray:WxH   the same from the upright picture
+//
+// A stack of N holds the last N frames, oldest first, as one tensor.
+
+typedef struct ObsFormat {
+    uint8_t rotate;
+    uint8_t gray;
+    uint16_t width;     // of the gray output
+    uint16_t height;
+    int stack;
+} ObsFormat;
+
+// Largest frame buffer the exporters take, 256 x 256, with both sides a
+// multiple of 8
+#define OBS_MAX_BYTES 0x2000
+
+typedef struct ObsStack {
+    ObsFormat format;
+    VideoFormat video;
+    size_t frame_bytes;
+    uint8_t *frames;    // stack slots, a ring
+    int head;           // the oldest frame
+} ObsStack;
+
+int ObsParse(const char *arg, ObsFormat *format);
+size_t ObsFrameBytes(const ObsFormat *format, const VideoFormat *video);
+void ObsExport(const ObsFormat *format, const VideoFormat *video, const uint8_t *vram, uint8_t *out);
+void ObsExportScalar(const ObsFormat *format, const VideoFormat *video, const uint8_t *vram, uint8_t *out);
+
+ObsStack *ObsStackCreate(const ObsFormat *format, const VideoFormat *video);
+void ObsStackFill(ObsStack *stack, const uint8_t *vram);
+void ObsStackPush(ObsStack *stack, const uint8_t *vram);
+void ObsStackWrite(const ObsStack *stack, uint8_t *out);
+void ObsStackFree(ObsStack *stack);
+
+#endif
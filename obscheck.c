@@ -0,0 +1,105 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "obs.h"
+
+// Checks the SIMD observation exporters against the scalar path on random
+// frame buffers, for every format, including gray sizes that leave ragged
+// boxes and frame buffers whose sides are not multiples of 16. Needs no
+// ROMs.
+//
+//   obscheck [-seed N] [-frames N]
+
+static const VideoFormat videos[] = {
+    {0x2400, 256, 224},     // Space Invaders, 0x2400-0x3fff
+    {0x0000, 200, 120},
+};
+
+static const char *const formats[] = {
+    "packed", "rotated",
+    "gray:1x1", "gray:3x1", "gray:7x5", "gray:13x17", "gray:33x29", "gray:84x84",
+    "gray:160x100", "gray:199x119", "gray:255x223", "gray:256x224",
+    "rotated-gray:1x1", "rotated-gray:5x7", "rotated-gray:17x13", "rotated-gray:84x84",
+    "rotated-gray:119x199", "rotated-gray:223x255", "rotated-gray:224x256",
+};
+
+static uint64_t rng;
+
+static uint64_t Random(void)
+{
+    rng ^= rng << 13;
+    rng ^= rng >> 7;
+    rng ^= rng << 17;
+    return rng;
+}
+
+// Whether ObsStackCreate would take the format, which the exporters
+// assume
+static int Fits(const ObsFormat *format, const VideoFormat *video)
+{
+    int width = format->rotate ? video->height : video->width;
+    int height = format->rotate ? video->width : video->height;
+    return !format->gray || (format->width <= width && format->height <= height &&
+                             (height + format->height - 1) / format->height <= 255);
+}
+
+// Frame 0 is all dark and frame 1 all lit; the rest are random
+static void Fill(uint8_t *vram, size_t size, int frame)
+{
+    if (frame < 2) {
+        memset(vram, frame ? 0xff : 0x00, size);
+        return;
+    }
+    for (size_t i = 0; i < size; i++)
+        vram[i] = Random();
+}
+
+int main(int argc, char **argv) {
+    uint64_t seed = 1;
+    int frames = 50;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-seed") == 0 && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "-frames") == 0 && i + 1 < argc) {
+            frames = atoi(argv[++i]);
+        } else {
+            printf("usage: %s [-seed N] [-frames N]\n", argv[0]);
+            return 1;
+        }
+    }
+    rng = seed ? seed : 1;
+
+    static uint8_t vram[OBS_MAX_BYTES], simd[0x10000], scalar[0x10000];
+    uint64_t checked = 0, failures = 0;
+    for (size_t v = 0; v < sizeof(videos) / sizeof(videos[0]); v++) {
+        const VideoFormat *video = &videos[v];
+        for (int frame = 0; frame < frames; frame++) {
+            Fill(vram, VideoBytes(video), frame);
+            for (size_t f = 0; f < sizeof(formats) / sizeof(formats[0]); f++) {
+                ObsFormat format;
+                if (ObsParse(formats[f], &format) != 0) {
+                    printf("error: bad format %s\n", formats[f]);
+                    return 1;
+                }
+                if (!Fits(&format, video))
+                    continue;
+                size_t size = ObsFrameBytes(&format, video);
+                ObsExport(&format, video, vram, simd);
+                ObsExportScalar(&format, video, vram, scalar);
+                checked++;
+                if (memcmp(simd, scalar, size) != 0) {
+                    size_t i = 0;
+                    while (simd[i] == scalar[i])
+                        i++;
+                    printf("%dx%d frame %d, %s: byte %zu is %02x, scalar %02x\n",
+                           video->width, video->height, frame, formats[f], i, simd[i], scalar[i]);
+                    failures++;
+                }
+            }
+        }
+    }
+    printf("%llu exports, %llu failures\n", (unsigned long long) checked,
+           (unsigned long long) failures);
+    return failures != 0;
+}
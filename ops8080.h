@@ -0,0 +1,471 @@
+#ifndef OPS8080_H
+#define OPS8080_H
+
+#include <stdint.h>
+
+// The 8080 instruction set as one table. Every core builds its handlers
+// from it: ops8080.inc expands it into the opcode switch, cpu8080.c into
+// the cycle and length tables, and the fused core runs the same OP_
+// macros for the opcodes it combines. Register operands are macro names,
+// so each handler is specialized for its registers at compile time.
+//
+// The OP_ macros expect the core to define:
+//
+//   A B C D E H L          8-bit registers, as lvalues
+//   BC DE HL               register pairs, read only
+//   SET_BC SET_DE SET_HL   pair stores
+//   SP PC CC               stack pointer, program counter, flags
+//   READ8 WRITE8           memory accesses through the map
+//   CYCLES INT_ENABLE HALTED
+//   PORT_IN PORT_OUT       the state's port handlers
+//
+// and `opcode` pointing at the opcode, with PC already past it and CYCLES
+// already charged the not-taken count.
+
+#define IMM8 (opcode[1])
+#define IMM16 ((uint16_t) (opcode[2] << 8 | opcode[1]))
+#define SET_SP(v) (SP = (v))
+
+// Flags
+
+#define OP_ZSP(value) do { \
+        uint8_t zsp_ = (value); \
+        CC.z = (zsp_ == 0); \
+        CC.s = zsp_ >> 7; \
+        CC.p = parity8080[zsp_]; \
+    } while (0)
+
+// A + value + carry; AC is the carry out of bit 3
+#define OP_ADDER(value, carry) do { \
+        uint8_t v_ = (value); \
+        uint16_t r_ = A + v_ + (carry); \
+        CC.cy = r_ >> 8; \
+        CC.ac = ((A ^ v_ ^ r_) >> 4) & 1; \
+        A = r_; \
+        OP_ZSP(A); \
+    } while (0)
+
+// A - value - borrow, done the way the ALU does it: A + ~value + !borrow,
+// with CY the inverted carry. CMP keeps A.
+#define OP_SUBTRACTER(value, borrow, keep) do { \
+        uint8_t v_ = ~(value); \
+        uint16_t r_ = A + v_ + !(borrow); \
+        CC.cy = !(r_ >> 8); \
+        CC.ac = ((A ^ v_ ^ r_) >> 4) & 1; \
+        OP_ZSP((uint8_t) r_); \
+        if (keep) \
+            A = r_; \
+    } while (0)
+
+#define OP_ADD(value) OP_ADDER(value, 0)
+#define OP_ADC(value) OP_ADDER(value, CC.cy)
+#define OP_SUB(value) OP_SUBTRACTER(value, 0, 1)
+#define OP_SBB(value) OP_SUBTRACTER(value, CC.cy, 1)
+#define OP_CMP(value) OP_SUBTRACTER(value, 0, 0)
+
+// ANA sets AC from bit 3 of the operands, as the 8080 does
+#define OP_ANA(value) do { \
+        uint8_t v_ = (value); \
+        CC.ac = ((A | v_) >> 3) & 1; \
+        A &= v_; \
+        CC.cy = 0; \
+        OP_ZSP(A); \
+    } while (0)
+
+#define OP_LOGIC(expr) do { \
+        A = (expr); \
+        CC.cy = 0; \
+        CC.ac = 0; \
+        OP_ZSP(A); \
+    } while (0)
+
+#define OP_XRA(value) OP_LOGIC(A ^ (value))
+#define OP_ORA(value) OP_LOGIC(A | (value))
+
+// The immediate form of an ALU operation
+#define OP_IMM(op) do { op(IMM8); PC++; } while (0)
+
+#define OP_INR(r) do { r++; CC.ac = ((r) & 0xf) == 0; OP_ZSP(r); } while (0)
+#define OP_DCR(r) do { r--; CC.ac = ((r) & 0xf) != 0xf; OP_ZSP(r); } while (0)
+
+#define OP_INR_M() do { \
+        uint8_t m_ = READ8(HL) + 1; \
+        CC.ac = (m_ & 0xf) == 0; \
+        OP_ZSP(m_); \
+        WRITE8(HL, m_); \
+    } while (0)
+
+#define OP_DCR_M() do { \
+        uint8_t m_ = READ8(HL) - 1; \
+        CC.ac = (m_ & 0xf) != 0xf; \
+        OP_ZSP(m_); \
+        WRITE8(HL, m_); \
+    } while (0)
+
+#define OP_DAD(pair) do { \
+        uint32_t r_ = HL + (pair); \
+        CC.cy = r_ >> 16; \
+        SET_HL(r_); \
+    } while (0)
+
+// Adds 6 to each digit that is out of range or carried, low digit first
+#define OP_DAA() do { \
+        uint8_t fix_ = 0, cy_ = CC.cy; \
+        if (CC.ac || (A & 0xf) > 9) \
+            fix_ = 0x06; \
+        if (CC.cy || (A >> 4) > 9 || ((A >> 4) >= 9 && (A & 0xf) > 9)) { \
+            fix_ |= 0x60; \
+            cy_ = 1; \
+        } \
+        OP_ADD(fix_); \
+        CC.cy = cy_; \
+    } while (0)
+
+#define OP_RLC() do { CC.cy = A >> 7; A = A << 1 | CC.cy; } while (0)
+#define OP_RRC() do { CC.cy = A & 1; A = A >> 1 | CC.cy << 7; } while (0)
+#define OP_RAL() do { uint8_t c_ = CC.cy; CC.cy = A >> 7; A = A << 1 | c_; } while (0)
+#define OP_RAR() do { uint8_t c_ = CC.cy; CC.cy = A & 1; A = A >> 1 | c_ << 7; } while (0)
+#define OP_CMA() (A = ~A)
+#define OP_STC() (CC.cy = 1)
+#define OP_CMC() (CC.cy = !CC.cy)
+
+// Data transfer
+
+#define OP_NOP() ((void) 0)
+#define OP_MOV(dst, src) (dst = (src))
+#define OP_STORE_M(src) WRITE8(HL, src)
+#define OP_MVI(r) do { r = IMM8; PC++; } while (0)
+#define OP_MVI_M() do { WRITE8(HL, IMM8); PC++; } while (0)
+#define OP_LXI(set) do { set(IMM16); PC += 2; } while (0)
+#define OP_INX(pair, set) set((pair) + 1)
+#define OP_DCX(pair, set) set((pair) - 1)
+#define OP_STAX(pair) WRITE8(pair, A)
+#define OP_LDAX(pair) (A = READ8(pair))
+#define OP_STA() do { WRITE8(IMM16, A); PC += 2; } while (0)
+#define OP_LDA() do { A = READ8(IMM16); PC += 2; } while (0)
+#define OP_SHLD() do { WRITE8(IMM16, L); WRITE8(IMM16 + 1, H); PC += 2; } while (0)
+#define OP_LHLD() do { L = READ8(IMM16); H = READ8(IMM16 + 1); PC += 2; } while (0)
+#define OP_XCHG() do { uint16_t t_ = DE; SET_DE(HL); SET_HL(t_); } while (0)
+
+// Stack
+
+#define OP_PUSH16(value) do { \
+        uint16_t p_ = (value); \
+        WRITE8(SP - 1, p_ >> 8); \
+        WRITE8(SP - 2, p_ & 0xff); \
+        SP -= 2; \
+    } while (0)
+
+#define OP_POP16(dst) do { \
+        dst = READ8(SP) | READ8(SP + 1) << 8; \
+        SP += 2; \
+    } while (0)
+
+// The flags byte PUSH PSW writes: S Z 0 AC 0 P 1 CY
+#define PSW_FLAGS() (CC.s << 7 | CC.z << 6 | CC.ac << 4 | CC.p << 2 | 0x02 | CC.cy)
+
+#define OP_PUSH(pair) OP_PUSH16(pair)
+#define OP_PUSH_PSW() OP_PUSH16(A << 8 | PSW_FLAGS())
+#define OP_POP(set) do { uint16_t v_; OP_POP16(v_); set(v_); } while (0)
+
+#define OP_POP_PSW() do { \
+        uint16_t v_; \
+        OP_POP16(v_); \
+        CC.s = v_ >> 7; \
+        CC.z = v_ >> 6; \
+        CC.ac = v_ >> 4; \
+        CC.p = v_ >> 2; \
+        CC.cy = v_; \
+        A = v_ >> 8; \
+    } while (0)
+
+#define OP_XTHL() do { \
+        uint8_t l_ = READ8(SP), h_ = READ8(SP + 1); \
+        WRITE8(SP, L); \
+        WRITE8(SP + 1, H); \
+        L = l_; \
+        H = h_; \
+    } while (0)
+
+#define OP_SPHL() (SP = HL)
+
+// Branches. Taken conditional calls and returns cost 6 more cycles.
+
+#define OP_JMP() (PC = IMM16)
+#define OP_JCOND(cond) do { if (cond) PC = IMM16; else PC += 2; } while (0)
+#define OP_CALL() do { OP_PUSH16(PC + 2); PC = IMM16; } while (0)
+#define OP_CCOND(cond) do { if (cond) { CYCLES += 6; OP_CALL(); } else PC += 2; } while (0)
+#define OP_RET() OP_POP16(PC)
+#define OP_RCOND(cond) do { if (cond) { CYCLES += 6; OP_RET(); } } while (0)
+#define OP_RST(n) do { OP_PUSH16(PC); PC = 8 * (n); } while (0)
+#define OP_PCHL() (PC = HL)
+
+// Machine control
+
+#define OP_HLT() (HALTED = 1)
+#define OP_EI() (INT_ENABLE = 1)
+#define OP_DI() (INT_ENABLE = 0)
+#define OP_IN() do { PC++; A = PORT_IN(opcode[1]); } while (0)
+#define OP_OUT() do { PC++; PORT_OUT(opcode[1], A); } while (0)
+
+// X(opcode, length, cycles, handler). Cycles are the not-taken count for
+// conditional calls and returns; * marks undocumented aliases.
+#define OPCODES8080(X) \
+    X(0x00, 1,  4, OP_NOP())                    /* NOP */ \
+    X(0x01, 3, 10, OP_LXI(SET_BC))              /* LXI B,d16 */ \
+    X(0x02, 1,  7, OP_STAX(BC))                 /* STAX B */ \
+    X(0x03, 1,  5, OP_INX(BC, SET_BC))          /* INX B */ \
+    X(0x04, 1,  5, OP_INR(B))                   /* INR B */ \
+    X(0x05, 1,  5, OP_DCR(B))                   /* DCR B */ \
+    X(0x06, 2,  7, OP_MVI(B))                   /* MVI B,d8 */ \
+    X(0x07, 1,  4, OP_RLC())                    /* RLC */ \
+    X(0x08, 1,  4, OP_NOP())                    /* NOP* */ \
+    X(0x09, 1, 10, OP_DAD(BC))                  /* DAD B */ \
+    X(0x0a, 1,  7, OP_LDAX(BC))                 /* LDAX B */ \
+    X(0x0b, 1,  5, OP_DCX(BC, SET_BC))          /* DCX B */ \
+    X(0x0c, 1,  5, OP_INR(C))                   /* INR C */ \
+    X(0x0d, 1,  5, OP_DCR(C))                   /* DCR C */ \
+    X(0x0e, 2,  7, OP_MVI(C))                   /* MVI C,d8 */ \
+    X(0x0f, 1,  4, OP_RRC())                    /* RRC */ \
+    X(0x10, 1,  4, OP_NOP())                    /* NOP* */ \
+    X(0x11, 3, 10, OP_LXI(SET_DE))              /* LXI D,d16 */ \
+    X(0x12, 1,  7, OP_STAX(DE))                 /* STAX D */ \
+    X(0x13, 1,  5, OP_INX(DE, SET_DE))          /* INX D */ \
+    X(0x14, 1,  5, OP_INR(D))                   /* INR D */ \
+    X(0x15, 1,  5, OP_DCR(D))                   /* DCR D */ \
+    X(0x16, 2,  7, OP_MVI(D))                   /* MVI D,d8 */ \
+    X(0x17, 1,  4, OP_RAL())                    /* RAL */ \
+    X(0x18, 1,  4, OP_NOP())                    /* NOP* */ \
+    X(0x19, 1, 10, OP_DAD(DE))                  /* DAD D */ \
+    X(0x1a, 1,  7, OP_LDAX(DE))                 /* LDAX D */ \
+    X(0x1b, 1,  5, OP_DCX(DE, SET_DE))          /* DCX D */ \
+    X(0x1c, 1,  5, OP_INR(E))                   /* INR E */ \
+    X(0x1d, 1,  5, OP_DCR(E))                   /* DCR E */ \
+    X(0x1e, 2,  7, OP_MVI(E))                   /* MVI E,d8 */ \
+    X(0x1f, 1,  4, OP_RAR())                    /* RAR */ \
+    X(0x20, 1,  4, OP_NOP())                    /* NOP* */ \
+    X(0x21, 3, 10, OP_LXI(SET_HL))              /* LXI H,d16 */ \
+    X(0x22, 3, 16, OP_SHLD())                   /* SHLD a16 */ \
+    X(0x23, 1,  5, OP_INX(HL, SET_HL))          /* INX H */ \
+    X(0x24, 1,  5, OP_INR(H))                   /* INR H */ \
+    X(0x25, 1,  5, OP_DCR(H))                   /* DCR H */ \
+    X(0x26, 2,  7, OP_MVI(H))                   /* MVI H,d8 */ \
+    X(0x27, 1,  4, OP_DAA())                    /* DAA */ \
+    X(0x28, 1,  4, OP_NOP())                    /* NOP* */ \
+    X(0x29, 1, 10, OP_DAD(HL))                  /* DAD H */ \
+    X(0x2a, 3, 16, OP_LHLD())                   /* LHLD a16 */ \
+    X(0x2b, 1,  5, OP_DCX(HL, SET_HL))          /* DCX H */ \
+    X(0x2c, 1,  5, OP_INR(L))                   /* INR L */ \
+    X(0x2d, 1,  5, OP_DCR(L))                   /* DCR L */ \
+    X(0x2e, 2,  7, OP_MVI(L))                   /* MVI L,d8 */ \
+    X(0x2f, 1,  4, OP_CMA())                    /* CMA */ \
+    X(0x30, 1,  4, OP_NOP())                    /* NOP* */ \
+    X(0x31, 3, 10, OP_LXI(SET_SP))              /* LXI SP,d16 */ \
+    X(0x32, 3, 13, OP_STA())                    /* STA a16 */ \
+    X(0x33, 1,  5, OP_INX(SP, SET_SP))          /* INX SP */ \
+    X(0x34, 1, 10, OP_INR_M())                  /* INR M */ \
+    X(0x35, 1, 10, OP_DCR_M())                  /* DCR M */ \
+    X(0x36, 2, 10, OP_MVI_M())                  /* MVI M,d8 */ \
+    X(0x37, 1,  4, OP_STC())                    /* STC */ \
+    X(0x38, 1,  4, OP_NOP())                    /* NOP* */ \
+    X(0x39, 1, 10, OP_DAD(SP))                  /* DAD SP */ \
+    X(0x3a, 3, 13, OP_LDA())                    /* LDA a16 */ \
+    X(0x3b, 1,  5, OP_DCX(SP, SET_SP))          /* DCX SP */ \
+    X(0x3c, 1,  5, OP_INR(A))                   /* INR A */ \
+    X(0x3d, 1,  5, OP_DCR(A))                   /* DCR A */ \
+    X(0x3e, 2,  7, OP_MVI(A))                   /* MVI A,d8 */ \
+    X(0x3f, 1,  4, OP_CMC())                    /* CMC */ \
+    X(0x40, 1,  5, OP_MOV(B, B))                /* MOV B,B */ \
+    X(0x41, 1,  5, OP_MOV(B, C))                /* MOV B,C */ \
+    X(0x42, 1,  5, OP_MOV(B, D))                /* MOV B,D */ \
+    X(0x43, 1,  5, OP_MOV(B, E))                /* MOV B,E */ \
+    X(0x44, 1,  5, OP_MOV(B, H))                /* MOV B,H */ \
+    X(0x45, 1,  5, OP_MOV(B, L))                /* MOV B,L */ \
+    X(0x46, 1,  7, OP_MOV(B, READ8(HL)))        /* MOV B,M */ \
+    X(0x47, 1,  5, OP_MOV(B, A))                /* MOV B,A */ \
+    X(0x48, 1,  5, OP_MOV(C, B))                /* MOV C,B */ \
+    X(0x49, 1,  5, OP_MOV(C, C))                /* MOV C,C */ \
+    X(0x4a, 1,  5, OP_MOV(C, D))                /* MOV C,D */ \
+    X(0x4b, 1,  5, OP_MOV(C, E))                /* MOV C,E */ \
+    X(0x4c, 1,  5, OP_MOV(C, H))                /* MOV C,H */ \
+    X(0x4d, 1,  5, OP_MOV(C, L))                /* MOV C,L */ \
+    X(0x4e, 1,  7, OP_MOV(C, READ8(HL)))        /* MOV C,M */ \
+    X(0x4f, 1,  5, OP_MOV(C, A))                /* MOV C,A */ \
+    X(0x50, 1,  5, OP_MOV(D, B))                /* MOV D,B */ \
+    X(0x51, 1,  5, OP_MOV(D, C))                /* MOV D,C */ \
+    X(0x52, 1,  5, OP_MOV(D, D))                /* MOV D,D */ \
+    X(0x53, 1,  5, OP_MOV(D, E))                /* MOV D,E */ \
+    X(0x54, 1,  5, OP_MOV(D, H))                /* MOV D,H */ \
+    X(0x55, 1,  5, OP_MOV(D, L))                /* MOV D,L */ \
+    X(0x56, 1,  7, OP_MOV(D, READ8(HL)))        /* MOV D,M */ \
+    X(0x57, 1,  5, OP_MOV(D, A))                /* MOV D,A */ \
+    X(0x58, 1,  5, OP_MOV(E, B))                /* MOV E,B */ \
+    X(0x59, 1,  5, OP_MOV(E, C))                /* MOV E,C */ \
+    X(0x5a, 1,  5, OP_MOV(E, D))                /* MOV E,D */ \
+    X(0x5b, 1,  5, OP_MOV(E, E))                /* MOV E,E */ \
+    X(0x5c, 1,  5, OP_MOV(E, H))                /* MOV E,H */ \
+    X(0x5d, 1,  5, OP_MOV(E, L))                /* MOV E,L */ \
+    X(0x5e, 1,  7, OP_MOV(E, READ8(HL)))        /* MOV E,M */ \
+    X(0x5f, 1,  5, OP_MOV(E, A))                /* MOV E,A */ \
+    X(0x60, 1,  5, OP_MOV(H, B))                /* MOV H,B */ \
+    X(0x61, 1,  5, OP_MOV(H, C))                /* MOV H,C */ \
+    X(0x62, 1,  5, OP_MOV(H, D))                /* MOV H,D */ \
+    X(0x63, 1,  5, OP_MOV(H, E))                /* MOV H,E */ \
+    X(0x64, 1,  5, OP_MOV(H, H))                /* MOV H,H */ \
+    X(0x65, 1,  5, OP_MOV(H, L))                /* MOV H,L */ \
+    X(0x66, 1,  7, OP_MOV(H, READ8(HL)))        /* MOV H,M */ \
+    X(0x67, 1,  5, OP_MOV(H, A))                /* MOV H,A */ \
+    X(0x68, 1,  5, OP_MOV(L, B))                /* MOV L,B */ \
+    X(0x69, 1,  5, OP_MOV(L, C))                /* MOV L,C */ \
+    X(0x6a, 1,  5, OP_MOV(L, D))                /* MOV L,D */ \
+    X(0x6b, 1,  5, OP_MOV(L, E))                /* MOV L,E */ \
+    X(0x6c, 1,  5, OP_MOV(L, H))                /* MOV L,H */ \
+    X(0x6d, 1,  5, OP_MOV(L, L))                /* MOV L,L */ \
+    X(0x6e, 1,  7, OP_MOV(L, READ8(HL)))        /* MOV L,M */ \
+    X(0x6f, 1,  5, OP_MOV(L, A))                /* MOV L,A */ \
+    X(0x70, 1,  7, OP_STORE_M(B))               /* MOV M,B */ \
+    X(0x71, 1,  7, OP_STORE_M(C))               /* MOV M,C */ \
+    X(0x72, 1,  7, OP_STORE_M(D))               /* MOV M,D */ \
+    X(0x73, 1,  7, OP_STORE_M(E))               /* MOV M,E */ \
+    X(0x74, 1,  7, OP_STORE_M(H))               /* MOV M,H */ \
+    X(0x75, 1,  7, OP_STORE_M(L))               /* MOV M,L */ \
+    X(0x76, 1,  7, OP_HLT())                    /* HLT */ \
+    X(0x77, 1,  7, OP_STORE_M(A))               /* MOV M,A */ \
+    X(0x78, 1,  5, OP_MOV(A, B))                /* MOV A,B */ \
+    X(0x79, 1,  5, OP_MOV(A, C))                /* MOV A,C */ \
+    X(0x7a, 1,  5, OP_MOV(A, D))                /* MOV A,D */ \
+    X(0x7b, 1,  5, OP_MOV(A, E))                /* MOV A,E */ \
+    X(0x7c, 1,  5, OP_MOV(A, H))                /* MOV A,H */ \
+    X(0x7d, 1,  5, OP_MOV(A, L))                /* MOV A,L */ \
+    X(0x7e, 1,  7, OP_MOV(A, READ8(HL)))        /* MOV A,M */ \
+    X(0x7f, 1,  5, OP_MOV(A, A))                /* MOV A,A */ \
+    X(0x80, 1,  4, OP_ADD(B))                   /* ADD B */ \
+    X(0x81, 1,  4, OP_ADD(C))                   /* ADD C */ \
+    X(0x82, 1,  4, OP_ADD(D))                   /* ADD D */ \
+    X(0x83, 1,  4, OP_ADD(E))                   /* ADD E */ \
+    X(0x84, 1,  4, OP_ADD(H))                   /* ADD H */ \
+    X(0x85, 1,  4, OP_ADD(L))                   /* ADD L */ \
+    X(0x86, 1,  7, OP_ADD(READ8(HL)))           /* ADD M */ \
+    X(0x87, 1,  4, OP_ADD(A))                   /* ADD A */ \
+    X(0x88, 1,  4, OP_ADC(B))                   /* ADC B */ \
+    X(0x89, 1,  4, OP_ADC(C))                   /* ADC C */ \
+    X(0x8a, 1,  4, OP_ADC(D))                   /* ADC D */ \
+    X(0x8b, 1,  4, OP_ADC(E))                   /* ADC E */ \
+    X(0x8c, 1,  4, OP_ADC(H))                   /* ADC H */ \
+    X(0x8d, 1,  4, OP_ADC(L))                   /* ADC L */ \
+    X(0x8e, 1,  7, OP_ADC(READ8(HL)))           /* ADC M */ \
+    X(0x8f, 1,  4, OP_ADC(A))                   /* ADC A */ \
+    X(0x90, 1,  4, OP_SUB(B))                   /* SUB B */ \
+    X(0x91, 1,  4, OP_SUB(C))                   /* SUB C */ \
+    X(0x92, 1,  4, OP_SUB(D))                   /* SUB D */ \
+    X(0x93, 1,  4, OP_SUB(E))                   /* SUB E */ \
+    X(0x94, 1,  4, OP_SUB(H))                   /* SUB H */ \
+    X(0x95, 1,  4, OP_SUB(L))                   /* SUB L */ \
+    X(0x96, 1,  7, OP_SUB(READ8(HL)))           /* SUB M */ \
+    X(0x97, 1,  4, OP_SUB(A))                   /* SUB A */ \
+    X(0x98, 1,  4, OP_SBB(B))                   /* SBB B */ \
+    X(0x99, 1,  4, OP_SBB(C))                   /* SBB C */ \
+    X(0x9a, 1,  4, OP_SBB(D))                   /* SBB D */ \
+    X(0x9b, 1,  4, OP_SBB(E))                   /* SBB E */ \
+    X(0x9c, 1,  4, OP_SBB(H))                   /* SBB H */ \
+    X(0x9d, 1,  4, OP_SBB(L))                   /* SBB L */ \
+    X(0x9e, 1,  7, OP_SBB(READ8(HL)))           /* SBB M */ \
+    X(0x9f, 1,  4, OP_SBB(A))                   /* SBB A */ \
+    X(0xa0, 1,  4, OP_ANA(B))                   /* ANA B */ \
+    X(0xa1, 1,  4, OP_ANA(C))                   /* ANA C */ \
+    X(0xa2, 1,  4, OP_ANA(D))                   /* ANA D */ \
+    X(0xa3, 1,  4, OP_ANA(E))                   /* ANA E */ \
+    X(0xa4, 1,  4, OP_ANA(H))                   /* ANA H */ \
+    X(0xa5, 1,  4, OP_ANA(L))                   /* ANA L */ \
+    X(0xa6, 1,  7, OP_ANA(READ8(HL)))           /* ANA M */ \
+    X(0xa7, 1,  4, OP_ANA(A))                   /* ANA A */ \
+    X(0xa8, 1,  4, OP_XRA(B))                   /* XRA B */ \
+    X(0xa9, 1,  4, OP_XRA(C))                   /* XRA C */ \
+    X(0xaa, 1,  4, OP_XRA(D))                   /* XRA D */ \
+    X(0xab, 1,  4, OP_XRA(E))                   /* XRA E */ \
+    X(0xac, 1,  4, OP_XRA(H))                   /* XRA H */ \
+    X(0xad, 1,  4, OP_XRA(L))                   /* XRA L */ \
+    X(0xae, 1,  7, OP_XRA(READ8(HL)))           /* XRA M */ \
+    X(0xaf, 1,  4, OP_XRA(A))                   /* XRA A */ \
+    X(0xb0, 1,  4, OP_ORA(B))                   /* ORA B */ \
+    X(0xb1, 1,  4, OP_ORA(C))                   /* ORA C */ \
+    X(0xb2, 1,  4, OP_ORA(D))                   /* ORA D */ \
+    X(0xb3, 1,  4, OP_ORA(E))                   /* ORA E */ \
+    X(0xb4, 1,  4, OP_ORA(H))                   /* ORA H */ \
+    X(0xb5, 1,  4, OP_ORA(L))                   /* ORA L */ \
+    X(0xb6, 1,  7, OP_ORA(READ8(HL)))           /* ORA M */ \
+    X(0xb7, 1,  4, OP_ORA(A))                   /* ORA A */ \
+    X(0xb8, 1,  4, OP_CMP(B))                   /* CMP B */ \
+    X(0xb9, 1,  4, OP_CMP(C))                   /* CMP C */ \
+    X(0xba, 1,  4, OP_CMP(D))                   /* CMP D */ \
+    X(0xbb, 1,  4, OP_CMP(E))                   /* CMP E */ \
+    X(0xbc, 1,  4, OP_CMP(H))                   /* CMP H */ \
+    X(0xbd, 1,  4, OP_CMP(L))                   /* CMP L */ \
+    X(0xbe, 1,  7, OP_CMP(READ8(HL)))           /* CMP M */ \
+    X(0xbf, 1,  4, OP_CMP(A))                   /* CMP A */ \
+    X(0xc0, 1,  5, OP_RCOND(!CC.z))             /* RNZ */ \
+    X(0xc1, 1, 10, OP_POP(SET_BC))              /* POP B */ \
+    X(0xc2, 3, 10, OP_JCOND(!CC.z))             /* JNZ a16 */ \
+    X(0xc3, 3, 10, OP_JMP())                    /* JMP a16 */ \
+    X(0xc4, 3, 11, OP_CCOND(!CC.z))             /* CNZ a16 */ \
+    X(0xc5, 1, 11, OP_PUSH(BC))                 /* PUSH B */ \
+    X(0xc6, 2,  7, OP_IMM(OP_ADD))              /* ADI d8 */ \
+    X(0xc7, 1, 11, OP_RST(0))                   /* RST 0 */ \
+    X(0xc8, 1,  5, OP_RCOND(CC.z))              /* RZ */ \
+    X(0xc9, 1, 10, OP_RET())                    /* RET */ \
+    X(0xca, 3, 10, OP_JCOND(CC.z))              /* JZ a16 */ \
+    X(0xcb, 3, 10, OP_JMP())                    /* JMP* a16 */ \
+    X(0xcc, 3, 11, OP_CCOND(CC.z))              /* CZ a16 */ \
+    X(0xcd, 3, 17, OP_CALL())                   /* CALL a16 */ \
+    X(0xce, 2,  7, OP_IMM(OP_ADC))              /* ACI d8 */ \
+    X(0xcf, 1, 11, OP_RST(1))                   /* RST 1 */ \
+    X(0xd0, 1,  5, OP_RCOND(!CC.cy))            /* RNC */ \
+    X(0xd1, 1, 10, OP_POP(SET_DE))              /* POP D */ \
+    X(0xd2, 3, 10, OP_JCOND(!CC.cy))            /* JNC a16 */ \
+    X(0xd3, 2, 10, OP_OUT())                    /* OUT d8 */ \
+    X(0xd4, 3, 11, OP_CCOND(!CC.cy))            /* CNC a16 */ \
+    X(0xd5, 1, 11, OP_PUSH(DE))                 /* PUSH D */ \
+    X(0xd6, 2,  7, OP_IMM(OP_SUB))              /* SUI d8 */ \
+    X(0xd7, 1, 11, OP_RST(2))                   /* RST 2 */ \
+    X(0xd8, 1,  5, OP_RCOND(CC.cy))             /* RC */ \
+    X(0xd9, 1, 10, OP_RET())                    /* RET* */ \
+    X(0xda, 3, 10, OP_JCOND(CC.cy))             /* JC a16 */ \
+    X(0xdb, 2, 10, OP_IN())                     /* IN d8 */ \
+    X(0xdc, 3, 11, OP_CCOND(CC.cy))             /* CC a16 */ \
+    X(0xdd, 3, 17, OP_CALL())                   /* CALL* a16 */ \
+    X(0xde, 2,  7, OP_IMM(OP_SBB))              /* SBI d8 */ \
+    X(0xdf, 1, 11, OP_RST(3))                   /* RST 3 */ \
+    X(0xe0, 1,  5, OP_RCOND(!CC.p))             /* RPO */ \
+    X(0xe1, 1, 10, OP_POP(SET_HL))              /* POP H */ \
+    X(0xe2, 3, 10, OP_JCOND(!CC.p))             /* JPO a16 */ \
+    X(0xe3, 1, 18, OP_XTHL())                   /* XTHL */ \
+    X(0xe4, 3, 11, OP_CCOND(!CC.p))             /* CPO a16 */ \
+    X(0xe5, 1, 11, OP_PUSH(HL))                 /* PUSH H */ \
+    X(0xe6, 2,  7, OP_IMM(OP_ANA))              /* ANI d8 */ \
+    X(0xe7, 1, 11, OP_RST(4))                   /* RST 4 */ \
+    X(0xe8, 1,  5, OP_RCOND(CC.p))              /* RPE */ \
+    X(0xe9, 1,  5, OP_PCHL())                   /* PCHL */ \
+    X(0xea, 3, 10, OP_JCOND(CC.p))              /* JPE a16 */ \
+    X(0xeb, 1,  4, OP_XCHG())                   /* XCHG */ \
+    X(0xec, 3, 11, OP_CCOND(CC.p))              /* CPE a16 */ \
+    X(0xed, 3, 17, OP_CALL())                   /* CALL* a16 */ \
+    X(0xee, 2,  7, OP_IMM(OP_XRA))              /* XRI d8 */ \
+    X(0xef, 1, 11, OP_RST(5))                   /* RST 5 */ \
+    X(0xf0, 1,  5, OP_RCOND(!CC.s))             /* RP */ \
+    X(0xf1, 1, 10, OP_POP_PSW())                /* POP PSW */ \
+    X(0xf2, 3, 10, OP_JCOND(!CC.s))             /* JP a16 */ \
+    X(0xf3, 1,  4, OP_DI())                     /* DI */ \
+    X(0xf4, 3, 11, OP_CCOND(!CC.s))             /* CP a16 */ \
+    X(0xf5, 1, 11, OP_PUSH_PSW())               /* PUSH PSW */ \
+    X(0xf6, 2,  7, OP_IMM(OP_ORA))              /* ORI d8 */ \
+    X(0xf7, 1, 11, OP_RST(6))                   /* RST 6 */ \
+    X(0xf8, 1,  5, OP_RCOND(CC.s))              /* RM */ \
+    X(0xf9, 1,  5, OP_SPHL())                   /* SPHL */ \
+    X(0xfa, 3, 10, OP_JCOND(CC.s))              /* JM a16 */ \
+    X(0xfb, 1,  4, OP_EI())                     /* EI */ \
+    X(0xfc, 3, 11, OP_CCOND(CC.s))              /* CM a16 */ \
+    X(0xfd, 3, 17, OP_CALL())                   /* CALL* a16 */ \
+    X(0xfe, 2,  7, OP_IMM(OP_CMP))              /* CPI d8 */ \
+    X(0xff, 1, 11, OP_RST(7))                   /* RST 7 */
+
+#endif
@@ -0,0 +1,135 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "pacing.h"
+
+#define NS_PER_SEC 1000000000ull
+
+// When the host falls further behind than this many frames we give up
+// on catching up, otherwise the emulator would race to recover lost time.
+#define MAX_FRAMES_BEHIND 4
+
+uint64_t PacerNow(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * NS_PER_SEC + ts.tv_nsec;
+}
+
+static void SleepUntil(uint64_t deadline_ns)
+{
+    struct timespec ts;
+    ts.tv_sec = deadline_ns / NS_PER_SEC;
+    ts.tv_nsec = deadline_ns % NS_PER_SEC;
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) != 0)
+        ;   // interrupted by a signal, go back to sleep
+}
+
+void PacerInit(Pacer *pacer, PaceMode mode, double multiplier, double frame_hz) {
+    memset(pacer, 0, sizeof(*pacer));
+    pacer->mode = mode;
+    pacer->multiplier = (mode == PACE_REALTIME) ? 1.0 : multiplier;
+    pacer->frame_hz = frame_hz;
+    if (mode != PACE_MAX)
+        pacer->frame_ns = (uint64_t) (NS_PER_SEC / (frame_hz * pacer->multiplier));
+    pacer->start_ns = PacerNow();
+    pacer->last_frame_ns = pacer->start_ns;
+    pacer->deadline_ns = pacer->start_ns + pacer->frame_ns;
+}
+
+// Accepts "max", "realtime" or a multiplier such as "2x" or "0.5"
+int PacerParseMode(const char *arg, PaceMode *mode, double *multiplier) {
+    if (strcmp(arg, "max") == 0) {
+        *mode = PACE_MAX;
+        *multiplier = 0;
+        return 0;
+    }
+    if (strcmp(arg, "realtime") == 0) {
+        *mode = PACE_REALTIME;
+        *multiplier = 1.0;
+        return 0;
+    }
+    char *end;
+    double x = strtod(arg, &end);
+    if (end == arg || x <= 0 || (*end != '\0' && strcmp(end, "x") != 0))
+        return -1;
+    *mode = (x == 1.0) ? PACE_REALTIME : PACE_MULTIPLIER;
+    *multiplier = x;
+    return 0;
+}
+
+// Called once per emulated frame. Records the frame time and, unless
+// unthrottled, sleeps until the frame's slot in host time has come.
+void PacerFrame(Pacer *pacer) {
+    if (pacer->mode != PACE_MAX) {
+        uint64_t now = PacerNow();
+        if (now < pacer->deadline_ns) {
+            SleepUntil(pacer->deadline_ns);
+        } else {
+            pacer->late_frames++;
+            if (now - pacer->deadline_ns > MAX_FRAMES_BEHIND * pacer->frame_ns)
+                pacer->deadline_ns = now;
+        }
+        pacer->deadline_ns += pacer->frame_ns;
+    }
+
+    uint64_t now = PacerNow();
+    pacer->frame_times[pacer->history_pos] = now - pacer->last_frame_ns;
+    pacer->history_pos = (pacer->history_pos + 1) % PACE_HISTORY;
+    if (pacer->history_count < PACE_HISTORY)
+        pacer->history_count++;
+    pacer->last_frame_ns = now;
+    pacer->frames++;
+}
+
+// True when the frame about to be emulated has already missed its slot
+int PacerBehind(const Pacer *pacer) {
+    if (pacer->mode == PACE_MAX)
+        return 0;
+    return PacerNow() > pacer->deadline_ns;
+}
+
+// Achieved speed as a multiple of the real machine
+double PacerSpeed(const Pacer *pacer) {
+    uint64_t elapsed = pacer->last_frame_ns - pacer->start_ns;
+    if (elapsed == 0)
+        return 0;
+    return (double) pacer->frames * NS_PER_SEC / elapsed / pacer->frame_hz;
+}
+
+double PacerTargetSpeed(const Pacer *pacer) {
+    return pacer->mode == PACE_MAX ? 0 : pacer->multiplier;
+}
+
+static int CompareU64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *) a;
+    uint64_t y = *(const uint64_t *) b;
+    return (x > y) - (x < y);
+}
+
+// Frame time in ns at the given percentile (0-100) of recent frames
+uint64_t PacerFrameTimePercentile(const Pacer *pacer, double pct) {
+    uint64_t sorted[PACE_HISTORY];
+    int n = pacer->history_count;
+    if (n == 0)
+        return 0;
+    memcpy(sorted, pacer->frame_times, n * sizeof(uint64_t));
+    qsort(sorted, n, sizeof(uint64_t), CompareU64);
+    int i = (int) (pct / 100.0 * (n - 1) + 0.5);
+    return sorted[i];
+}
+
+void PacerReport(const Pacer *pacer, FILE *out) {
+    if (pacer->mode == PACE_MAX)
+        fprintf(out, "speed %.2fx (unthrottled)", PacerSpeed(pacer));
+    else
+        fprintf(out, "speed %.2fx (target %.2fx)", PacerSpeed(pacer), PacerTargetSpeed(pacer));
+    fprintf(out, "  frame ms p50 %.2f p90 %.2f p99 %.2f max %.2f  late %llu/%llu\n",
+            PacerFrameTimePercentile(pacer, 50) / 1e6,
+            PacerFrameTimePercentile(pacer, 90) / 1e6,
+            PacerFrameTimePercentile(pacer, 99) / 1e6,
+            PacerFrameTimePercentile(pacer, 100) / 1e6,
+            (unsigned long long) pacer->late_frames,
+            (unsigned long long) pacer->frames);
+}
@@ -0,0 +1,41 @@
+#ifndef PACING_H
+#define PACING_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+typedef enum PaceMode {
+    PACE_MAX,           // no throttling, run as fast as the host allows
+    PACE_REALTIME,      // 2 MHz, 60 Hz
+    PACE_MULTIPLIER,    // fixed multiple of real time
+} PaceMode;
+
+// Number of recent frame times kept for the jitter percentiles
+#define PACE_HISTORY 1024
+
+typedef struct Pacer {
+    PaceMode mode;
+    double multiplier;
+    double frame_hz;            // emulated frames per second at 1x
+    uint64_t frame_ns;          // host time budget per frame, 0 when unthrottled
+    uint64_t start_ns;
+    uint64_t deadline_ns;       // absolute time the next frame may start
+    uint64_t last_frame_ns;
+    uint64_t frames;
+    uint64_t late_frames;       // frames that missed their deadline
+    uint64_t frame_times[PACE_HISTORY];
+    int history_count;
+    int history_pos;
+} Pacer;
+
+uint64_t PacerNow(void);
+void PacerInit(Pacer *pacer, PaceMode mode, double multiplier, double frame_hz);
+int PacerParseMode(const char *arg, PaceMode *mode, double *multiplier);
+void PacerFrame(Pacer *pacer);
+int PacerBehind(const Pacer *pacer);
+double PacerSpeed(const Pacer *pacer);
+double PacerTargetSpeed(const Pacer *pacer);
+uint64_t PacerFrameTimePercentile(const Pacer *pacer, double pct);
+void PacerReport(const Pacer *pacer, FILE *out);
+
+#endif
@@ -0,0 +1,40 @@
+#!/bin/sh
+# Profile-guided release build. Builds instrumented binaries, trains them
+# on the invaders attract-mode replay and the benchmarks, then rebuilds
+# with the collected profile in the same build/pgo tree, so the object
+# paths the profile is keyed on match.
+#
+#   ./pgo.sh [rom-dir]
+#
+# The invaders replays are skipped when the ROMs are not in rom-dir
+# (default: the source directory), and so is cpudiag.com.
+set -e
+
+src=$(cd "$(dirname "$0")" && pwd)
+roms=$(cd "${1:-$src}" && pwd)
+profile="$src/build/pgo-profile"
+
+cd "$src"
+rm -rf "$profile"
+cmake --preset pgo-generate
+cmake --build --preset pgo-generate -j
+
+bin="$src/build/pgo"
+if [ -f "$roms/invaders.h" ]; then
+    (cd "$roms" && "$bin/emu8080-headless" -journal "$src/tests/attract.journal" -frames 3600)
+    (cd "$roms" && "$bin/emu8080-headless" -journal "$src/tests/play.journal" -frames 1800 -nofuse)
+else
+    echo "pgo: no ROMs in $roms, training on the benchmarks only"
+fi
+if [ -f "$roms/cpudiag.com" ]; then
+    (cd "$roms" && "$bin/cpm8080" cpudiag.com)
+fi
+"$bin/bench" 50000000
+"$bin/fuzz8080" -cases 20000
+
+if [ -n "$(find "$profile" -name '*.profraw' 2>/dev/null)" ]; then
+    llvm-profdata merge -output="$profile/default.profdata" "$profile"/*.profraw
+fi
+
+cmake --preset pgo-use
+cmake --build --preset pgo-use -j
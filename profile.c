@@ -0,0 +1,103 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "profile.h"
+#include "cpu8080.h"
+#include "disasm.h"
+
+Profile profile8080;
+
+void ProfileReset(void) {
+    memset(&profile8080, 0, sizeof(profile8080));
+}
+
+static const uint64_t *sort_key;
+
+static int CompareByKey(const void *a, const void *b)
+{
+    uint64_t x = sort_key[*(const uint32_t *) a];
+    uint64_t y = sort_key[*(const uint32_t *) b];
+    return (x < y) - (x > y);   // descending
+}
+
+// Indices of the nonzero entries of key[0..n), hottest first
+static uint32_t *SortedIndices(const uint64_t *key, uint32_t n, uint32_t *count)
+{
+    uint32_t *idx = malloc(n * sizeof(uint32_t));
+    uint32_t k = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        if (key[i])
+            idx[k++] = i;
+    }
+    sort_key = key;
+    qsort(idx, k, sizeof(uint32_t), CompareByKey);
+    *count = k;
+    return idx;
+}
+
+static int OpcodeMnemonic(uint8_t op)
+{
+    uint8_t code[3] = {op, 0, 0};
+    Instr8080 ins;
+    Decode8080(code, 0, &ins);
+    return ins.mnemonic;
+}
+
+static double Percent(uint64_t part, uint64_t total)
+{
+    return total ? 100.0 * part / total : 0;
+}
+
+// Prints the hottest opcodes, opcode pairs and PCs. Hot PCs are mapped
+// back to their instruction through the disassembler.
+void ProfileReport(unsigned char *memory, int top) {
+    const Profile *p = &profile8080;
+    uint64_t total_ops = 0, total_cycles = 0;
+    uint32_t n;
+
+    for (int i = 0; i < 256; i++) {
+        total_ops += p->op_count[i];
+        total_cycles += p->op_cycles[i];
+    }
+    printf("%llu instructions, %llu cycles\n",
+            (unsigned long long) total_ops, (unsigned long long) total_cycles);
+
+    printf("\ncycles per instruction:\n");
+    for (int i = 0; i < PROFILE_MAX_CYCLES; i++) {
+        if (p->cycle_hist[i])
+            printf("  %2d  %12llu  %5.1f%%\n", i, (unsigned long long) p->cycle_hist[i],
+                    Percent(p->cycle_hist[i], total_ops));
+    }
+
+    uint32_t *ops = SortedIndices(p->op_cycles, 256, &n);
+    printf("\nhot opcodes by cycles:\n");
+    for (uint32_t i = 0; i < n && i < (uint32_t) top; i++) {
+        uint32_t op = ops[i];
+        printf("  %02x %-5s %12llu ops  %12llu cycles  %5.1f%%\n", op, Mnemonic8080(OpcodeMnemonic(op)),
+                (unsigned long long) p->op_count[op], (unsigned long long) p->op_cycles[op],
+                Percent(p->op_cycles[op], total_cycles));
+    }
+    free(ops);
+
+    uint32_t *pairs = SortedIndices(p->pair_count, 256 * 256, &n);
+    printf("\nhot opcode pairs:\n");
+    for (uint32_t i = 0; i < n && i < (uint32_t) top; i++) {
+        printf("  %02x %02x %-5s %-5s %12llu  %5.1f%%\n", pairs[i] >> 8, pairs[i] & 0xff,
+               Mnemonic8080(OpcodeMnemonic(pairs[i] >> 8)), Mnemonic8080(OpcodeMnemonic(pairs[i] & 0xff)),
+               (unsigned long long) p->pair_count[pairs[i]], Percent(p->pair_count[pairs[i]], total_ops));
+    }
+    free(pairs);
+
+    uint32_t *pcs = SortedIndices(p->pc_cycles, 0x10000, &n);
+    printf("\nhot PCs by cycles:\n");
+    for (uint32_t i = 0; i < n && i < (uint32_t) top; i++) {
+        uint32_t pc = pcs[i];
+        Instr8080 ins;
+        char text[32];
+        Decode8080(&memory[pc], pc, &ins);
+        Format8080(&ins, text, sizeof(text), NULL);
+        printf("  %12llu  %5.1f%%  %04x %s\n", (unsigned long long) p->pc_count[pc],
+               Percent(p->pc_cycles[pc], total_cycles), pc, text);
+    }
+    free(pcs);
+}
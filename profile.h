@@ -0,0 +1,45 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stdint.h>
+
+// Execution profile of the core. Counting is compiled in only when the
+// emulator is built with -DPROFILE; otherwise PROFILE_RECORD expands to
+// nothing and the core runs unchanged.
+
+#define PROFILE_MAX_CYCLES 32   // no 8080 instruction takes longer
+
+typedef struct Profile {
+    uint64_t op_count[256];
+    uint64_t op_cycles[256];
+    uint64_t pc_count[0x10000];
+    uint64_t pc_cycles[0x10000];
+    uint64_t pair_count[256 * 256];     // indexed by previous opcode << 8 | opcode
+    uint64_t cycle_hist[PROFILE_MAX_CYCLES];
+    uint8_t last_op;
+} Profile;
+
+extern Profile profile8080;
+
+static inline void ProfileRecord(uint16_t pc, uint8_t op, uint32_t cycles)
+{
+    Profile *p = &profile8080;
+    p->op_count[op]++;
+    p->op_cycles[op] += cycles;
+    p->pc_count[pc]++;
+    p->pc_cycles[pc] += cycles;
+    p->pair_count[p->last_op << 8 | op]++;
+    p->cycle_hist[cycles & (PROFILE_MAX_CYCLES - 1)]++;
+    p->last_op = op;
+}
+
+#ifdef PROFILE
+#define PROFILE_RECORD(pc, op, cycles) ProfileRecord(pc, op, cycles)
+#else
+#define PROFILE_RECORD(pc, op, cycles) ((void) 0)
+#endif
+
+void ProfileReset(void);
+void ProfileReport(unsigned char *memory, int top);
+
+#endif
@@ -0,0 +1,117 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "rewind.h"
+#include "pacing.h"
+
+static Snapshot *Slot(const Rewind *rw, int i)
+{
+    return (Snapshot *) (rw->arena + (size_t) i * rw->slot_size);
+}
+
+// Collects the backing pages some address can write
+static int WritablePages(const State8080 *state, uint8_t *page)
+{
+    uint8_t seen[257] = {0};
+    int npages = 0;
+    for (int p = 0; p < 256; p++) {
+        uint32_t backing = state->map->write[p] >> 8;
+        if (backing < 256 && !seen[backing]) {
+            seen[backing] = 1;
+            page[npages++] = backing;
+        }
+    }
+    return npages;
+}
+
+// Bytes one snapshot of this machine takes in the arena
+size_t RewindSlotSize(const State8080 *state) {
+    uint8_t page[256];
+    size_t size = sizeof(Snapshot) + (size_t) WritablePages(state, page) * 256;
+    return (size + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE;
+}
+
+// The whole arena is allocated here, sized by `budget` bytes; snapshots
+// never allocate. Only backing pages some address can write are saved,
+// which for the invaders board is the 8K of RAM.
+Rewind *RewindCreate(const State8080 *state, size_t budget, int interval) {
+    Rewind *rw = calloc(1, sizeof(Rewind));
+    rw->npages = WritablePages(state, rw->page);
+    rw->slot_size = RewindSlotSize(state);
+    rw->slots = budget / rw->slot_size;
+    if (rw->slots < 1) {
+        printf("error: rewind budget of %zu bytes is less than one %zu byte snapshot\n",
+               budget, rw->slot_size);
+        exit(1);
+    }
+    rw->arena = aligned_alloc(CACHE_LINE, rw->slots * rw->slot_size);
+    rw->interval = interval > 0 ? interval : 1;
+    return rw;
+}
+
+// Called once per frame, after the frame's input has been applied
+void RewindFrame(Rewind *rw, uint64_t frame, const State8080 *state, const Scheduler *sched, const Video *video) {
+    rw->frames++;
+    if (frame % rw->interval)
+        return;
+
+    uint64_t t0 = PacerNow();
+    Snapshot *snap = Slot(rw, rw->head);
+    snap->frame = frame;
+    snap->cpu = *state;
+    snap->sched = *sched;
+    snap->video = *video;
+    uint8_t *out = (uint8_t *) (snap + 1);
+    for (int i = 0; i < rw->npages; i++, out += 256)
+        memcpy(out, &state->memory[rw->page[i] << 8], 256);
+
+    rw->head = (rw->head + 1) % rw->slots;
+    if (rw->count < rw->slots)
+        rw->count++;
+    rw->snapshots++;
+    rw->snapshot_ns += PacerNow() - t0;
+}
+
+// Restores the newest snapshot at or before `frame` and drops the ones
+// after it. Returns the snapshot's frame, or -1 when none is that old.
+int64_t RewindTo(Rewind *rw, uint64_t frame, State8080 *state, Scheduler *sched, Video *video) {
+    while (rw->count > 0) {
+        int newest = (rw->head + rw->slots - 1) % rw->slots;
+        const Snapshot *snap = Slot(rw, newest);
+        if (snap->frame > frame) {
+            rw->head = newest;
+            rw->count--;
+            continue;
+        }
+
+        // The pointers stay with the live objects
+        State8080 live = *state;
+        *state = snap->cpu;
+        state->memory = live.memory;
+        state->map = live.map;
+        state->idle = live.idle;
+        *sched = snap->sched;
+        *video = snap->video;
+
+        // Marking the pages dirty drops fused code decoded from them
+        const uint8_t *in = (const uint8_t *) (snap + 1);
+        for (int i = 0; i < rw->npages; i++, in += 256) {
+            memcpy(&state->memory[rw->page[i] << 8], in, 256);
+            state->map->dirty[rw->page[i]] = DIRTY_ALL;
+        }
+        return snap->frame;
+    }
+    return -1;
+}
+
+void RewindReport(const Rewind *rw, FILE *out) {
+    fprintf(out, "rewind: %d slots of %zu bytes, %llu snapshots, %.2f us each, %.3f us per frame\n",
+            rw->slots, rw->slot_size, (unsigned long long) rw->snapshots,
+            rw->snapshots ? rw->snapshot_ns / 1e3 / rw->snapshots : 0.0,
+            rw->frames ? rw->snapshot_ns / 1e3 / rw->frames : 0.0);
+}
+
+void RewindFree(Rewind *rw) {
+    free(rw->arena);
+    free(rw);
+}
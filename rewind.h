@@ -0,0 +1,46 @@
+#ifndef REWIND_H
+#define REWIND_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "cpu8080.h"
+#include "scheduler.h"
+#include "machine.h"
+
+// Rewind buffer. Every `interval` frames the CPU, the scheduler, the beam
+// and the writable pages of memory are copied into the next slot of a
+// ring carved out of one arena, overwriting the oldest. Going back
+// restores the newest snapshot at or before the wanted frame; the caller
+// then replays forward from the input journal (see JournalSeek).
+
+typedef struct Snapshot {
+    uint64_t frame;
+    State8080 cpu;
+    Scheduler sched;
+    Video video;
+    // followed by the saved pages
+} Snapshot;
+
+typedef struct Rewind {
+    uint8_t *arena;
+    size_t slot_size;
+    int slots;
+    int head;               // next slot to write
+    int count;
+    int interval;
+    int npages;
+    uint8_t page[256];      // backing pages that can be written
+    uint64_t snapshots;
+    uint64_t snapshot_ns;
+    uint64_t frames;
+} Rewind;
+
+size_t RewindSlotSize(const State8080 *state);
+Rewind *RewindCreate(const State8080 *state, size_t budget, int interval);
+void RewindFrame(Rewind *rw, uint64_t frame, const State8080 *state, const Scheduler *sched, const Video *video);
+int64_t RewindTo(Rewind *rw, uint64_t frame, State8080 *state, Scheduler *sched, Video *video);
+void RewindReport(const Rewind *rw, FILE *out);
+void RewindFree(Rewind *rw);
+
+#endif
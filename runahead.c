@@ -0,0 +1,56 @@
+#include <stdlib.h>
+#include "runahead.h"
+#include "pacing.h"
+#include "counters.h"
+
+// The snapshot is the rewind buffer's, so only writable pages are copied
+RunAhead *RunAheadCreate(const State8080 *state, DecodeCache *cache, int frames) {
+    RunAhead *ra = calloc(1, sizeof(RunAhead));
+    ra->rw = RewindCreate(state, RewindSlotSize(state), 1);
+    ra->cache = cache;
+    ra->counters = state->counters ? CountersCreate("runahead") : NULL;
+    ra->frames = frames;
+    return ra;
+}
+
+void RunAheadBegin(RunAhead *ra, State8080 *state, Scheduler *sched, Video *video) {
+    uint64_t t0 = PacerNow();
+    RewindFrame(ra->rw, 0, state, sched, video);
+    uint64_t t1 = PacerNow();
+
+    // The restore doesn't take back what was counted
+    struct Counters *counters = state->counters;
+    state->counters = ra->counters;
+    uint64_t frame_start = t1;
+    for (int f = 0; f < ra->frames && MachineRunFrame(state, ra->cache, sched, video); f++) {
+        uint64_t now = PacerNow();
+        if (ra->counters)
+            CountersFrame(ra->counters, now - frame_start);
+        frame_start = now;
+    }
+    state->counters = counters;
+    uint64_t t2 = PacerNow();
+
+    ra->runs++;
+    ra->save_ns += t1 - t0;
+    ra->ahead_ns += t2 - t1;
+}
+
+void RunAheadEnd(RunAhead *ra, State8080 *state, Scheduler *sched, Video *video) {
+    uint64_t t0 = PacerNow();
+    RewindTo(ra->rw, 0, state, sched, video);
+    ra->restore_ns += PacerNow() - t0;
+}
+
+// The extra host time per frame shown, and its share of a 60 Hz frame
+void RunAheadReport(const RunAhead *ra, FILE *out) {
+    if (!ra->runs)
+        return;
+    double save = ra->save_ns / 1e3 / ra->runs;
+    double ahead = ra->ahead_ns / 1e3 / ra->runs;
+    double restore = ra->restore_ns / 1e3 / ra->runs;
+    double total = save + ahead + restore;
+    fprintf(out, "run-ahead %d: %.1f us extra per frame (save %.1f, run %.1f, restore %.1f), "
+            "%.1f%% of a frame\n", ra->frames, total, save, ahead, restore,
+            total * FRAMES_PER_SECOND / 1e4);
+}
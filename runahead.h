@@ -0,0 +1,41 @@
+#ifndef RUNAHEAD_H
+#define RUNAHEAD_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "cpu8080.h"
+#include "scheduler.h"
+#include "fused.h"
+#include "machine.h"
+#include "rewind.h"
+
+// Run-ahead hides the frame of lag the game adds by reading its input once
+// per frame. Before a frame is shown, the machine is snapshotted, run
+// `frames` more frames with the input as it stands, and the frontend
+// shows that; then the snapshot is restored and the real frame goes on.
+//
+//   RunAheadBegin(ra, state, sched, video);
+//   ... draw from VRAM ...
+//   RunAheadEnd(ra, state, sched, video);
+//
+// The speculative frames are counted in a "runahead" set of counters of
+// their own, if the state has counters when the run-ahead is created, so
+// the state's counters only see the frames that really happen.
+
+typedef struct RunAhead {
+    Rewind *rw;             // a single slot
+    DecodeCache *cache;     // NULL runs the slice core
+    struct Counters *counters;
+    int frames;
+    uint64_t runs;
+    uint64_t save_ns;
+    uint64_t ahead_ns;
+    uint64_t restore_ns;
+} RunAhead;
+
+RunAhead *RunAheadCreate(const State8080 *state, DecodeCache *cache, int frames);
+void RunAheadBegin(RunAhead *ra, State8080 *state, Scheduler *sched, Video *video);
+void RunAheadEnd(RunAhead *ra, State8080 *state, Scheduler *sched, Video *video);
+void RunAheadReport(const RunAhead *ra, FILE *out);
+
+#endif
@@ -0,0 +1,88 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "scheduler.h"
+
+static void SiftUp(Scheduler *sched, int i)
+{
+    Event ev = sched->heap[i];
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (sched->heap[parent].when <= ev.when)
+            break;
+        sched->heap[i] = sched->heap[parent];
+        i = parent;
+    }
+    sched->heap[i] = ev;
+}
+
+static void SiftDown(Scheduler *sched, int i)
+{
+    Event ev = sched->heap[i];
+    for (;;) {
+        int child = 2 * i + 1;
+        if (child >= sched->count)
+            break;
+        if (child + 1 < sched->count && sched->heap[child + 1].when < sched->heap[child].when)
+            child++;
+        if (ev.when <= sched->heap[child].when)
+            break;
+        sched->heap[i] = sched->heap[child];
+        i = child;
+    }
+    sched->heap[i] = ev;
+}
+
+void SchedulerInit(Scheduler *sched) {
+    sched->count = 0;
+}
+
+static void Push(Scheduler *sched, uint64_t when, EventHandler handler, CoroutineFunc resume, void *ctx)
+{
+    if (sched->count == SCHEDULER_MAX_EVENTS) {
+        printf("error: Scheduler is full (%d events)\n", SCHEDULER_MAX_EVENTS);
+        exit(1);
+    }
+    Event *ev = &sched->heap[sched->count];
+    ev->when = when;
+    ev->handler = handler;
+    ev->resume = resume;
+    ev->ctx = ctx;
+    SiftUp(sched, sched->count++);
+}
+
+void SchedulerAdd(Scheduler *sched, uint64_t when, EventHandler handler, void *ctx) {
+    Push(sched, when, handler, NULL, ctx);
+}
+
+// Starts a device coroutine; its first resume is at `when`
+void SchedulerSpawn(Scheduler *sched, uint64_t when, CoroutineFunc resume, void *ctx) {
+    Push(sched, when, NULL, resume, ctx);
+}
+
+void SchedulerCancel(Scheduler *sched, EventHandler handler, void *ctx) {
+    int kept = 0;
+    for (int i = 0; i < sched->count; i++) {
+        if (sched->heap[i].handler != handler || sched->heap[i].ctx != ctx)
+            sched->heap[kept++] = sched->heap[i];
+    }
+    sched->count = kept;
+    for (int i = kept / 2 - 1; i >= 0; i--)
+        SiftDown(sched, i);
+}
+
+void SchedulerRunDue(Scheduler *sched, uint64_t now) {
+    while (sched->count && sched->heap[0].when <= now) {
+        // pop before dispatching so the handler may re-arm itself
+        Event ev = sched->heap[0];
+        sched->heap[0] = sched->heap[--sched->count];
+        if (sched->count)
+            SiftDown(sched, 0);
+        if (ev.resume) {
+            uint64_t next = ev.resume(ev.ctx, ev.when);
+            if (next != CO_DONE)
+                Push(sched, next, NULL, ev.resume, ev.ctx);
+        } else {
+            ev.handler(ev.ctx, ev.when);
+        }
+    }
+}
@@ -0,0 +1,41 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stdint.h>
+#include "coroutine.h"
+
+// Maximum number of pending events. Devices register a handful of
+// periodic events each, so a small fixed heap avoids any allocation.
+#define SCHEDULER_MAX_EVENTS 32
+
+// Called once the CPU cycle counter has reached `when`. One-shot events
+// are plain handlers; devices are coroutines, re-armed at the cycle each
+// resume returns until it returns CO_DONE.
+typedef void (*EventHandler)(void *ctx, uint64_t when);
+
+typedef struct Event {
+    uint64_t when;
+    EventHandler handler;
+    CoroutineFunc resume;
+    void *ctx;
+} Event;
+
+// Min-heap of timed events keyed by CPU cycle count
+typedef struct Scheduler {
+    Event heap[SCHEDULER_MAX_EVENTS];
+    int count;
+} Scheduler;
+
+void SchedulerInit(Scheduler *sched);
+void SchedulerAdd(Scheduler *sched, uint64_t when, EventHandler handler, void *ctx);
+void SchedulerSpawn(Scheduler *sched, uint64_t when, CoroutineFunc resume, void *ctx);
+void SchedulerCancel(Scheduler *sched, EventHandler handler, void *ctx);
+void SchedulerRunDue(Scheduler *sched, uint64_t now);
+
+// Cycle count of the earliest pending event; the CPU can run freely until then.
+static inline uint64_t SchedulerNext(const Scheduler *sched)
+{
+    return sched->count ? sched->heap[0].when : UINT64_MAX;
+}
+
+#endif
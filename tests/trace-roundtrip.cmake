@@ -0,0 +1,22 @@
+# Records a trace of random fuzz cases, unpacks it to text, packs the
+# text again and checks tracediff finds no difference, so the varint and
+# zigzag coding survives large PC and SP jumps both ways.
+#
+#   cmake -DFUZZ=fuzz8080 -DTRACEDIFF=tracediff -DDIR=out -P trace-roundtrip.cmake
+
+function(run)
+    execute_process(COMMAND ${ARGV} RESULT_VARIABLE result OUTPUT_VARIABLE output)
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "${ARGV} failed:\n${output}")
+    endif()
+    set(output "${output}" PARENT_SCOPE)
+endfunction()
+
+run(${FUZZ} -cases 2000 -trace ${DIR}/roundtrip-a.trc)
+run(${TRACEDIFF} -unpack ${DIR}/roundtrip-a.trc ${DIR}/roundtrip.txt)
+run(${TRACEDIFF} -pack ${DIR}/roundtrip.txt ${DIR}/roundtrip-b.trc)
+run(${TRACEDIFF} ${DIR}/roundtrip-a.trc ${DIR}/roundtrip-b.trc)
+if(NOT output MATCHES "traces match, [1-9][0-9]* records")
+    message(FATAL_ERROR "unexpected tracediff output:\n${output}")
+endif()
+message(STATUS "${output}")
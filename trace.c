@@ -0,0 +1,166 @@
+#include <stdlib.h>
+#include <string.h>
+#include "trace.h"
+
+Trace *TraceCreate(const char *path) {
+    Trace *trace = calloc(1, sizeof(Trace));
+    trace->f = fopen(path, "wb");
+    if (trace->f == NULL) {
+        printf("error: Couldn't open %s\n", path);
+        exit(1);
+    }
+    fwrite(TRACE_MAGIC, 1, 8, trace->f);
+    trace->writing = 1;
+    return trace;
+}
+
+static void Flush(Trace *trace)
+{
+    fwrite(trace->buf, 1, trace->pos, trace->f);
+    trace->pos = 0;
+}
+
+static void PutVarint(Trace *trace, uint32_t v)
+{
+    while (v >= 0x80) {
+        trace->buf[trace->pos++] = (v & 0x7f) | 0x80;
+        v >>= 7;
+    }
+    trace->buf[trace->pos++] = v;
+}
+
+static uint32_t ZigZag(int32_t v)
+{
+    return ((uint32_t) v << 1) ^ (uint32_t) (v >> 31);
+}
+
+static int32_t UnZigZag(uint32_t v)
+{
+    return (int32_t) (v >> 1) ^ -(int32_t) (v & 1);
+}
+
+// Deltas wrap at 16 bits so they always fit in three varint bytes
+static int32_t Delta16(uint16_t now, uint16_t before)
+{
+    return (int16_t) (uint16_t) (now - before);
+}
+
+void TraceAppend(Trace *trace, const TraceRecord *rec) {
+    // a record is at most 1 + 1 + 3 + 3 + 8 bytes
+    if (trace->pos > TRACE_BUFFER - 16)
+        Flush(trace);
+
+    uint8_t mask = 0;
+    for (int i = 0; i < 8; i++) {
+        if (rec->reg[i] != trace->last.reg[i] || trace->records == 0)
+            mask |= 1 << i;
+    }
+    int sp_changed = rec->sp != trace->last.sp || trace->records == 0;
+
+    trace->buf[trace->pos++] = mask;
+    trace->buf[trace->pos++] = rec->opcode;
+    PutVarint(trace, ZigZag(Delta16(rec->pc, trace->last.pc)) << 1 | sp_changed);
+    if (sp_changed)
+        PutVarint(trace, ZigZag(Delta16(rec->sp, trace->last.sp)));
+    for (int i = 0; i < 8; i++) {
+        if (mask & (1 << i))
+            trace->buf[trace->pos++] = rec->reg[i];
+    }
+    trace->last = *rec;
+    trace->records++;
+}
+
+void TraceClose(Trace *trace) {
+    if (trace->writing)
+        Flush(trace);
+    fclose(trace->f);
+    free(trace);
+}
+
+Trace *TraceOpen(const char *path) {
+    char magic[8];
+    Trace *trace = calloc(1, sizeof(Trace));
+    trace->f = fopen(path, "rb");
+    if (trace->f == NULL || fread(magic, 1, 8, trace->f) != 8 || memcmp(magic, TRACE_MAGIC, 8) != 0) {
+        printf("error: %s is not a trace\n", path);
+        exit(1);
+    }
+    return trace;
+}
+
+// -1 at end of file
+static int GetByte(Trace *trace)
+{
+    if (trace->pos == trace->len) {
+        trace->len = fread(trace->buf, 1, TRACE_BUFFER, trace->f);
+        trace->pos = 0;
+        if (trace->len == 0)
+            return -1;
+    }
+    return trace->buf[trace->pos++];
+}
+
+static uint32_t GetVarint(Trace *trace)
+{
+    uint32_t v = 0;
+    int shift = 0, b;
+    do {
+        b = GetByte(trace);
+        if (b < 0)
+            return 0;
+        v |= (uint32_t) (b & 0x7f) << shift;
+        shift += 7;
+    } while (b & 0x80);
+    return v;
+}
+
+// Reads the next record into rec. Returns 0 at the end of the trace.
+int TraceNext(Trace *trace, TraceRecord *rec) {
+    int mask = GetByte(trace);
+    int opcode = GetByte(trace);
+    if (mask < 0 || opcode < 0)
+        return 0;
+    *rec = trace->last;
+    rec->opcode = opcode;
+    uint32_t pc = GetVarint(trace);
+    rec->pc = trace->last.pc + UnZigZag(pc >> 1);
+    if (pc & 1)
+        rec->sp = trace->last.sp + UnZigZag(GetVarint(trace));
+    for (int i = 0; i < 8; i++) {
+        if (mask & (1 << i))
+            rec->reg[i] = GetByte(trace);
+    }
+    trace->last = *rec;
+    trace->records++;
+    return 1;
+}
+
+void TraceCapture(const State8080 *state, TraceRecord *rec) {
+    rec->pc = state->pc;
+    rec->sp = state->sp;
+    rec->opcode = MemRead(state, state->pc);
+    rec->reg[0] = state->a;
+    rec->reg[1] = state->cc.s << 7 | state->cc.z << 6 | state->cc.ac << 4 |
+                  state->cc.p << 2 | 0x02 | state->cc.cy;
+    rec->reg[2] = state->b;
+    rec->reg[3] = state->c;
+    rec->reg[4] = state->d;
+    rec->reg[5] = state->e;
+    rec->reg[6] = state->h;
+    rec->reg[7] = state->l;
+}
+
+// Runs the CPU like Run8080, appending a record before every opcode
+void TraceRun(Trace *trace, State8080 *state, uint64_t until) {
+    TraceRecord rec;
+    while (state->cycles < until) {
+        if (state->halted) {
+            if (state->int_enable)
+                state->cycles = until;
+            break;
+        }
+        TraceCapture(state, &rec);
+        TraceAppend(trace, &rec);
+        Emulate8080Op(state);
+    }
+}
@@ -0,0 +1,49 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "cpu8080.h"
+
+// Compact binary execution trace. One record per instruction, taken
+// before it executes:
+//
+//   mask    changed registers, bit 0-7 = A F B C D E H L
+//   opcode
+//   varint  zigzag(PC - previous PC) << 1 | SP changed
+//   varint  zigzag(SP - previous SP), when SP changed
+//   bytes   the changed registers, in mask order
+//
+// F is the standard 8080 PSW byte (S Z 0 AC 0 P 1 CY), so traces from
+// other emulators can be converted and compared.
+
+#define TRACE_MAGIC "8080TRC1"
+#define TRACE_BUFFER (1 << 16)
+
+typedef struct TraceRecord {
+    uint16_t pc;
+    uint16_t sp;
+    uint8_t opcode;
+    uint8_t reg[8];         // A F B C D E H L
+} TraceRecord;
+
+typedef struct Trace {
+    FILE *f;
+    TraceRecord last;
+    uint64_t records;
+    int writing;
+    size_t pos;
+    size_t len;             // reader: bytes in buf
+    uint8_t buf[TRACE_BUFFER];
+} Trace;
+
+Trace *TraceCreate(const char *path);
+void TraceAppend(Trace *trace, const TraceRecord *rec);
+void TraceClose(Trace *trace);
+Trace *TraceOpen(const char *path);
+int TraceNext(Trace *trace, TraceRecord *rec);
+
+void TraceCapture(const State8080 *state, TraceRecord *rec);
+void TraceRun(Trace *trace, State8080 *state, uint64_t until);
+
+#endif
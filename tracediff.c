@@ -0,0 +1,169 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "trace.h"
+#include "disasm.h"
+#include "pacing.h"
+
+// Streams two binary traces and reports the first record where they
+// disagree, with the records leading up to it. Memory use is fixed no
+// matter how long the traces are.
+//
+//   tracediff a.trc b.trc
+//   tracediff -dump a.trc
+//   tracediff -pack text.log out.trc
+//   tracediff -unpack a.trc text.log
+//
+// -pack converts a text trace from another emulator, one instruction per
+// line as hex fields: PC OP A F B C D E H L SP. -unpack writes that
+// format back.
+
+#define CONTEXT 16
+
+static const char *const reg_names[8] = { "a", "f", "b", "c", "d", "e", "h", "l" };
+
+static void PrintRecord(uint64_t n, const TraceRecord *rec)
+{
+    uint8_t code[3] = { rec->opcode, 0, 0 };
+    Instr8080 instr;
+
+    // only the opcode is in the trace, so operands print as zero
+    Decode8080(code, 0, &instr);
+    printf("%12llu  %04x  %02x %-6s a=%02x f=%02x b=%02x c=%02x d=%02x e=%02x h=%02x l=%02x sp=%04x\n",
+           (unsigned long long) n, rec->pc, rec->opcode, Mnemonic8080(instr.mnemonic),
+           rec->reg[0], rec->reg[1], rec->reg[2], rec->reg[3],
+           rec->reg[4], rec->reg[5], rec->reg[6], rec->reg[7], rec->sp);
+}
+
+static int Differ(const TraceRecord *a, const TraceRecord *b)
+{
+    return a->pc != b->pc || a->sp != b->sp || a->opcode != b->opcode ||
+           memcmp(a->reg, b->reg, sizeof(a->reg)) != 0;
+}
+
+static int Diff(const char *path_a, const char *path_b)
+{
+    Trace *a = TraceOpen(path_a);
+    Trace *b = TraceOpen(path_b);
+    TraceRecord ra, rb, history[CONTEXT];
+    uint64_t n = 0;
+    uint64_t start = PacerNow();
+    int more_a, more_b, result = 0;
+
+    for (;;) {
+        more_a = TraceNext(a, &ra);
+        more_b = TraceNext(b, &rb);
+        if (!more_a || !more_b)
+            break;
+        if (Differ(&ra, &rb))
+            break;
+        history[n % CONTEXT] = ra;
+        n++;
+    }
+    double seconds = (PacerNow() - start) / 1e9;
+
+    if (more_a && more_b) {
+        printf("traces diverge at record %llu\n", (unsigned long long) n);
+        uint64_t first = n > CONTEXT ? n - CONTEXT : 0;
+        for (uint64_t i = first; i < n; i++)
+            PrintRecord(i, &history[i % CONTEXT]);
+        printf("%s:\n", path_a);
+        PrintRecord(n, &ra);
+        printf("%s:\n", path_b);
+        PrintRecord(n, &rb);
+        if (ra.pc != rb.pc)
+            printf("pc differs\n");
+        if (ra.opcode != rb.opcode)
+            printf("opcode differs\n");
+        if (ra.sp != rb.sp)
+            printf("sp differs\n");
+        for (int i = 0; i < 8; i++) {
+            if (ra.reg[i] != rb.reg[i])
+                printf("%s differs\n", reg_names[i]);
+        }
+        result = 1;
+    } else if (more_a || more_b) {
+        printf("%s ends after %llu records\n", more_a ? path_b : path_a, (unsigned long long) n);
+        result = 1;
+    } else {
+        printf("traces match, %llu records\n", (unsigned long long) n);
+    }
+    printf("compared %.1fM records/s\n", seconds > 0 ? n / seconds / 1e6 : 0.0);
+    TraceClose(a);
+    TraceClose(b);
+    return result;
+}
+
+static int Dump(const char *path)
+{
+    Trace *trace = TraceOpen(path);
+    TraceRecord rec;
+    uint64_t n = 0;
+    while (TraceNext(trace, &rec))
+        PrintRecord(n++, &rec);
+    TraceClose(trace);
+    return 0;
+}
+
+static int Unpack(const char *path, const char *text)
+{
+    FILE *out = fopen(text, "w");
+    if (out == NULL) {
+        printf("error: Couldn't create %s\n", text);
+        exit(1);
+    }
+    Trace *trace = TraceOpen(path);
+    TraceRecord rec;
+    while (TraceNext(trace, &rec)) {
+        fprintf(out, "%04x %02x", rec.pc, rec.opcode);
+        for (int i = 0; i < 8; i++)
+            fprintf(out, " %02x", rec.reg[i]);
+        fprintf(out, " %04x\n", rec.sp);
+    }
+    printf("unpacked %llu records\n", (unsigned long long) trace->records);
+    TraceClose(trace);
+    fclose(out);
+    return 0;
+}
+
+static int Pack(const char *text, const char *out)
+{
+    FILE *in = fopen(text, "r");
+    if (in == NULL) {
+        printf("error: Couldn't open %s\n", text);
+        exit(1);
+    }
+    Trace *trace = TraceCreate(out);
+    TraceRecord rec;
+    char line[256];
+    unsigned v[11];
+    while (fgets(line, sizeof(line), in)) {
+        if (sscanf(line, "%x %x %x %x %x %x %x %x %x %x %x", &v[0], &v[1], &v[2], &v[3],
+                   &v[4], &v[5], &v[6], &v[7], &v[8], &v[9], &v[10]) != 11)
+            continue;
+        rec.pc = v[0];
+        rec.opcode = v[1];
+        for (int i = 0; i < 8; i++)
+            rec.reg[i] = v[2 + i];
+        rec.sp = v[10];
+        TraceAppend(trace, &rec);
+    }
+    printf("packed %llu records\n", (unsigned long long) trace->records);
+    fclose(in);
+    TraceClose(trace);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    if (argc == 3 && strcmp(argv[1], "-dump") == 0)
+        return Dump(argv[2]);
+    if (argc == 4 && strcmp(argv[1], "-pack") == 0)
+        return Pack(argv[2], argv[3]);
+    if (argc == 4 && strcmp(argv[1], "-unpack") == 0)
+        return Unpack(argv[2], argv[3]);
+    if (argc == 3 && argv[1][0] != '-')
+        return Diff(argv[1], argv[2]);
+    printf("usage: %s a.trc b.trc | -dump a.trc | -pack text.log out.trc | -unpack a.trc text.log\n",
+           argv[0]);
+    return 1;
+}